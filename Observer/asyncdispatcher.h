@@ -0,0 +1,240 @@
+#ifndef _ASYNCDISPATCHER_H_
+#define _ASYNCDISPATCHER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "eventqueue.h"
+#include "latencyhistogram.h"
+
+// Delivers stock events on dispatcher threads instead of the caller's.
+//
+// Every dispatcher thread owns one bounded lock-free queue and products
+// are assigned to threads by id, so the events of one product are always
+// delivered in the order they were published. When a queue is full the
+// backpressure policy decides: Block waits for space, DropOldest discards
+// the oldest queued event, and Coalesce keeps at most one queued event per
+// product that always carries the latest state.
+class AsyncDispatcher {
+public:
+    enum class Backpressure { Block, DropOldest, Coalesce };
+
+    struct Options {
+        unsigned threads = 1;
+        size_t queueCapacity = 4096;    // per dispatcher thread
+        Backpressure backpressure = Backpressure::Block;
+    };
+
+    struct Metrics {
+        uint64_t published = 0;
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;
+        uint64_t coalesced = 0;
+        size_t queueDepth = 0;
+        size_t maxQueueDepth = 0;
+        // from publish() until the deliver callback returned
+        double meanLatencyNs = 0.0;
+        uint64_t p50LatencyNs = 0;
+        uint64_t p99LatencyNs = 0;
+        uint64_t p999LatencyNs = 0;
+        uint64_t maxLatencyNs = 0;
+    };
+
+    using Deliver = std::function<void(uint32_t product, bool inStock)>;
+
+private:
+    struct Event {
+        uint32_t product;
+        bool inStock;
+        bool coalescing;    // the latest state is in the coalescing slot
+        int64_t publishedNs;
+    };
+
+    struct Lane {
+        EventQueue<Event> queue;
+        std::atomic<uint32_t> itemsSignal{0};
+        std::atomic<uint32_t> spaceSignal{0};
+        std::thread thread;
+
+        explicit Lane(size_t capacity) : queue(capacity) {}
+    };
+
+    Deliver deliver;
+    Options options;
+    std::vector<std::unique_ptr<Lane>> lanes;
+    std::atomic<bool> stopping{false};
+
+    // Coalesce: slot (product & slotMask) holds (product + 1) << 1 | inStock
+    // while an event of that product is queued
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    size_t slotMask = 0;
+
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<size_t> depth{0};
+    std::atomic<size_t> maxDepth{0};
+    LatencyHistogram latency;
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t slotValue(uint32_t product, bool inStock) {
+        return (static_cast<uint64_t>(product) + 1) << 1 | (inStock ? 1 : 0);
+    }
+
+    void push(Lane& lane, const Event& event) {
+        // counted before the push, so a consumer never sees it negative
+        size_t queued = depth.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t seen = maxDepth.load(std::memory_order_relaxed);
+        while (queued > seen && !maxDepth.compare_exchange_weak(seen, queued, std::memory_order_relaxed)) {
+        }
+
+        while (!lane.queue.tryPush(event)) {
+            if (options.backpressure == Backpressure::DropOldest) {
+                Event oldest;
+                if (lane.queue.tryPop(oldest)) {
+                    depth.fetch_sub(1, std::memory_order_relaxed);
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                continue;
+            }
+            // Block, and Coalesce once more products are queued than fit
+            uint32_t signal = lane.spaceSignal.load(std::memory_order_acquire);
+            if (lane.queue.tryPush(event)) {
+                break;
+            }
+            lane.spaceSignal.wait(signal, std::memory_order_acquire);
+        }
+
+        lane.itemsSignal.fetch_add(1, std::memory_order_release);
+        lane.itemsSignal.notify_one();
+    }
+
+    // true if the change was merged into an event that is still queued
+    bool coalesce(Event& event) {
+        std::atomic<uint64_t>& slot = slots[event.product & slotMask];
+        uint64_t value = slotValue(event.product, event.inStock);
+        uint64_t current = slot.load(std::memory_order_acquire);
+        while (true) {
+            if (current >> 1 == static_cast<uint64_t>(event.product) + 1) {
+                if (slot.compare_exchange_weak(current, value, std::memory_order_acq_rel)) {
+                    return true;
+                }
+            } else if (current == 0) {
+                if (slot.compare_exchange_weak(current, value, std::memory_order_acq_rel)) {
+                    event.coalescing = true;
+                    return false;
+                }
+            } else {
+                return false;   // slot taken by another product, queue this one as is
+            }
+        }
+    }
+
+    void run(Lane& lane) {
+        Event event;
+        while (true) {
+            uint32_t signal = lane.itemsSignal.load(std::memory_order_acquire);
+            if (!lane.queue.tryPop(event)) {
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                lane.itemsSignal.wait(signal, std::memory_order_acquire);
+                continue;
+            }
+            depth.fetch_sub(1, std::memory_order_relaxed);
+            lane.spaceSignal.fetch_add(1, std::memory_order_release);
+            lane.spaceSignal.notify_all();
+
+            if (event.coalescing) {
+                // take the latest state; later changes queue a new event
+                uint64_t value = slots[event.product & slotMask].exchange(0, std::memory_order_acq_rel);
+                event.inStock = (value & 1) != 0;
+            }
+            deliver(event.product, event.inStock);
+            latency.record(static_cast<uint64_t>(nowNs() - event.publishedNs));
+            delivered.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+public:
+    AsyncDispatcher(Deliver deliver, const Options& options) : deliver(std::move(deliver)), options(options) {
+        unsigned threads = options.threads > 0 ? options.threads : 1;
+        if (options.backpressure == Backpressure::Coalesce) {
+            size_t size = 1;
+            while (size < 4 * options.queueCapacity * threads) {
+                size *= 2;
+            }
+            slots.reset(new std::atomic<uint64_t>[size]());
+            slotMask = size - 1;
+        }
+        for (unsigned t = 0; t < threads; t++) {
+            lanes.push_back(std::make_unique<Lane>(options.queueCapacity));
+        }
+        for (std::unique_ptr<Lane>& lane : lanes) {
+            Lane* l = lane.get();
+            lane->thread = std::thread([this, l] { run(*l); });
+        }
+    }
+
+    AsyncDispatcher(const AsyncDispatcher&) = delete;
+    AsyncDispatcher& operator=(const AsyncDispatcher&) = delete;
+
+    // delivers what is still queued, then stops the threads
+    ~AsyncDispatcher() {
+        drain();
+        stopping.store(true, std::memory_order_release);
+        for (std::unique_ptr<Lane>& lane : lanes) {
+            lane->itemsSignal.fetch_add(1, std::memory_order_release);
+            lane->itemsSignal.notify_all();
+        }
+        for (std::unique_ptr<Lane>& lane : lanes) {
+            lane->thread.join();
+        }
+    }
+
+    void publish(uint32_t product, bool inStock) {
+        published.fetch_add(1, std::memory_order_relaxed);
+        Event event{product, inStock, false, nowNs()};
+        if (options.backpressure == Backpressure::Coalesce && coalesce(event)) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        push(*lanes[product % lanes.size()], event);
+    }
+
+    // waits until every event published so far is delivered or dropped
+    void drain() {
+        while (delivered.load(std::memory_order_acquire) + dropped.load(std::memory_order_acquire)
+               + coalesced.load(std::memory_order_acquire) < published.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    Metrics getMetrics() const {
+        Metrics metrics;
+        metrics.published = published.load(std::memory_order_relaxed);
+        metrics.delivered = delivered.load(std::memory_order_relaxed);
+        metrics.dropped = dropped.load(std::memory_order_relaxed);
+        metrics.coalesced = coalesced.load(std::memory_order_relaxed);
+        metrics.queueDepth = depth.load(std::memory_order_relaxed);
+        metrics.maxQueueDepth = maxDepth.load(std::memory_order_relaxed);
+        metrics.meanLatencyNs = latency.getMean();
+        metrics.p50LatencyNs = latency.percentile(0.50);
+        metrics.p99LatencyNs = latency.percentile(0.99);
+        metrics.p999LatencyNs = latency.percentile(0.999);
+        metrics.maxLatencyNs = latency.getMax();
+        return metrics;
+    }
+};
+
+#endif // _ASYNCDISPATCHER_H_
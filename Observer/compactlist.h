@@ -0,0 +1,130 @@
+#ifndef _COMPACTLIST_H_
+#define _COMPACTLIST_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+// Unordered list of small, trivially copyable values. Up to
+// InlineCapacity values are stored inside the object itself, so the
+// many products with only one or two subscribers need no allocation.
+// Larger lists move to the heap and come back once they shrink again.
+// erase() moves the last value into the gap, so it does not keep order.
+template <typename T, uint32_t InlineCapacity>
+class CompactList {
+    static_assert(std::is_trivially_copyable_v<T>, "values are copied with memcpy semantics");
+
+private:
+    uint32_t count = 0;
+    uint32_t capacity = InlineCapacity;
+    union {
+        T inlineItems[InlineCapacity];
+        T* heapItems;
+    };
+
+    bool onHeap() const {
+        return capacity > InlineCapacity;
+    }
+
+    void reallocate(uint32_t newCapacity) {
+        if (newCapacity > InlineCapacity) {
+            T* items = new T[newCapacity];
+            std::copy(data(), data() + count, items);
+            if (onHeap()) {
+                delete[] heapItems;
+            }
+            heapItems = items;
+        } else {
+            // the inline array overlaps only the pointer, not the heap block
+            T* items = heapItems;
+            std::copy(items, items + count, inlineItems);
+            delete[] items;
+        }
+        capacity = newCapacity;
+    }
+
+    void takeFrom(CompactList& other) {
+        count = other.count;
+        capacity = other.capacity;
+        if (other.onHeap()) {
+            heapItems = other.heapItems;
+        } else {
+            std::copy(other.inlineItems, other.inlineItems + count, inlineItems);
+        }
+        other.count = 0;
+        other.capacity = InlineCapacity;
+    }
+
+public:
+    CompactList() {}
+
+    CompactList(const CompactList&) = delete;
+    CompactList& operator=(const CompactList&) = delete;
+
+    CompactList(CompactList&& other) noexcept {
+        takeFrom(other);
+    }
+
+    CompactList& operator=(CompactList&& other) noexcept {
+        if (this != &other) {
+            if (onHeap()) {
+                delete[] heapItems;
+            }
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~CompactList() {
+        if (onHeap()) {
+            delete[] heapItems;
+        }
+    }
+
+    T* data() {
+        return onHeap() ? heapItems : inlineItems;
+    }
+
+    const T* data() const {
+        return onHeap() ? heapItems : inlineItems;
+    }
+
+    T* begin() { return data(); }
+    T* end() { return data() + count; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + count; }
+
+    uint32_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    bool contains(T value) const {
+        return std::find(begin(), end(), value) != end();
+    }
+
+    void push_back(T value) {
+        if (count == capacity) {
+            reallocate(capacity * 2);
+        }
+        data()[count++] = value;
+    }
+
+    // removes one occurrence of value, returns false if there was none
+    bool erase(T value) {
+        T* it = std::find(begin(), end(), value);
+        if (it == end()) {
+            return false;
+        }
+        *it = data()[--count];
+        if (onHeap() && count <= InlineCapacity) {
+            reallocate(InlineCapacity);
+        }
+        return true;
+    }
+};
+
+#endif // _COMPACTLIST_H_
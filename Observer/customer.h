@@ -0,0 +1,23 @@
+#ifndef _CUSTOMER_H_
+#define _CUSTOMER_H_
+
+#include <iostream>
+#include <string>
+
+#include "observer.h"
+
+// Concrete Observer class. The stock manager only notifies a customer
+// about products it subscribed to, so there is nothing to filter here.
+class Customer : public Observer {
+private:
+    std::string name;
+
+public:
+    Customer(const std::string& name) : name(name) {}
+
+    void update(const std::string& productName) override {
+        std::cout << "Notification for " << name << ": " << productName << " is back in stock!" << std::endl;
+    }
+};
+
+#endif // _CUSTOMER_H_
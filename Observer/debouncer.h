@@ -0,0 +1,291 @@
+#ifndef _DEBOUNCER_H_
+#define _DEBOUNCER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "timerwheel.h"
+
+// Holds back restock notifications of flapping products.
+//
+// A restock of a product without an open window is delivered at once and
+// opens a window on a timer wheel; further restocks inside the window only
+// mark the product as restocked again. When the window ends and the
+// product was restocked within it, the timer thread asks deliver() to
+// notify with the product's state at that moment, so a product that is
+// sold out again by then is not announced, and a new window opens. A
+// product that does not flap is therefore announced without delay, and
+// every product notifies at most once per window. Every restock that did
+// not lead to a notification is counted as suppressed.
+class Debouncer {
+public:
+    struct Options {
+        std::chrono::milliseconds window{100};
+        std::chrono::milliseconds tick{10};     // resolution of the wheel
+    };
+
+    struct Metrics {
+        uint64_t submitted = 0;     // restocks seen
+        uint64_t delivered = 0;
+        uint64_t suppressed = 0;
+        size_t pending = 0;         // open windows
+    };
+
+    // Notifies about product if it is still in stock and returns whether
+    // it did
+    using Deliver = std::function<bool(uint32_t product)>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Two bits per product, whether its window is open and whether it was
+    // restocked within it, in words allocated lazily in segments that
+    // double in size, so the table only grows up to the highest id seen
+    class WindowStates {
+    private:
+        static constexpr uint64_t OPEN = 1;
+        static constexpr uint64_t RESTOCKED = 2;
+        static constexpr uint32_t PER_WORD = 32;
+
+        // segment k holds the 2^k words from 2^k - 1 on
+        static constexpr int SEGMENTS = 28;
+
+        std::atomic<std::atomic<uint64_t>*> segments[SEGMENTS] = {};
+
+        std::atomic<uint64_t>& word(uint32_t product) {
+            uint32_t w = product / PER_WORD + 1;
+            int k = std::bit_width(w) - 1;
+            std::atomic<uint64_t>* segment = segments[k].load(std::memory_order_acquire);
+            if (segment == nullptr) {
+                // racing threads may both allocate; the loser frees its copy
+                std::atomic<uint64_t>* fresh = new std::atomic<uint64_t>[size_t(1) << k]();
+                if (segments[k].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel)) {
+                    segment = fresh;
+                } else {
+                    delete[] fresh;
+                }
+            }
+            return segment[w - (uint32_t(1) << k)];
+        }
+
+        static int shiftOf(uint32_t product) {
+            return static_cast<int>(product % PER_WORD) * 2;
+        }
+
+    public:
+        WindowStates() = default;
+
+        WindowStates(const WindowStates&) = delete;
+        WindowStates& operator=(const WindowStates&) = delete;
+
+        ~WindowStates() {
+            for (std::atomic<std::atomic<uint64_t>*>& segment : segments) {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Opens the window and returns true if it was closed, otherwise
+        // marks the product as restocked within it
+        bool open(uint32_t product) {
+            std::atomic<uint64_t>& states = word(product);
+            int shift = shiftOf(product);
+            uint64_t seen = states.load(std::memory_order_relaxed);
+            while (true) {
+                bool wasOpen = (seen >> shift & OPEN) != 0;
+                uint64_t next = seen | (wasOpen ? RESTOCKED : OPEN) << shift;
+                if (next == seen || states.compare_exchange_weak(seen, next, std::memory_order_acq_rel)) {
+                    return !wasOpen;
+                }
+            }
+        }
+
+        // When the window ends: if the product was restocked within it,
+        // keeps the window open for the next one and returns true,
+        // otherwise closes it
+        bool extend(uint32_t product) {
+            std::atomic<uint64_t>& states = word(product);
+            int shift = shiftOf(product);
+            uint64_t seen = states.load(std::memory_order_relaxed);
+            while (true) {
+                bool restocked = (seen >> shift & RESTOCKED) != 0;
+                uint64_t next = seen & ~((restocked ? RESTOCKED : OPEN) << shift);
+                if (states.compare_exchange_weak(seen, next, std::memory_order_acq_rel)) {
+                    return restocked;
+                }
+            }
+        }
+
+        // closes the window and returns whether the product was restocked
+        // within it
+        bool close(uint32_t product) {
+            int shift = shiftOf(product);
+            uint64_t seen = word(product).fetch_and(~((OPEN | RESTOCKED) << shift), std::memory_order_acq_rel);
+            return (seen >> shift & RESTOCKED) != 0;
+        }
+    };
+
+    Deliver deliver;
+    Options options;
+    uint64_t windowTicks;
+    Clock::time_point origin = Clock::now();
+
+    // open from a delivered restock until its timer fires
+    WindowStates windows;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    TimerWheel<uint32_t> wheel;
+    bool stopping = false;
+    std::thread timer;
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> suppressed{0};
+
+    uint64_t nowTick() const {
+        return static_cast<uint64_t>((Clock::now() - origin) / options.tick);
+    }
+
+    // Starts the window of product now, rather than at the tick the timer
+    // thread saw last, and adds the windows that ended before to due. The
+    // current tick has partly passed, so the window gets one more. The
+    // caller holds mutex.
+    void schedule(uint32_t product, std::vector<uint32_t>& due) {
+        wheel.advance(nowTick(), [&](uint32_t ended) { due.push_back(ended); });
+        wheel.schedule(product, windowTicks + 1);
+    }
+
+    // announces a restock that was counted as suppressed when it came
+    void deliverHeldBack(uint32_t product) {
+        if (deliver(product)) {
+            delivered.fetch_add(1, std::memory_order_relaxed);
+            suppressed.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // ends the windows of the products in due, and empties it
+    void fire(std::vector<uint32_t>& due) {
+        std::vector<uint32_t> extended;
+        while (!due.empty()) {
+            for (uint32_t product : due) {
+                if (windows.extend(product)) {
+                    deliverHeldBack(product);
+                    extended.push_back(product);
+                }
+            }
+            due.clear();
+            if (!extended.empty()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (uint32_t product : extended) {
+                    schedule(product, due);
+                }
+                extended.clear();
+            }
+        }
+    }
+
+    void run() {
+        std::vector<uint32_t> due;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (wheel.empty()) {
+                wakeup.wait(lock);
+                continue;
+            }
+            wakeup.wait_until(lock, origin + (wheel.getCurrentTick() + 1) * options.tick);
+            wheel.advance(nowTick(), [&](uint32_t product) { due.push_back(product); });
+            if (!due.empty()) {
+                lock.unlock();
+                fire(due);
+                due.clear();
+                lock.lock();
+            }
+        }
+    }
+
+public:
+    Debouncer(Deliver deliver, const Options& options)
+        : deliver(std::move(deliver)), options(options),
+          // the window rounded up to whole ticks
+          windowTicks(std::max<uint64_t>(1, (options.window + options.tick - std::chrono::milliseconds(1))
+                                                / options.tick)),
+          wheel(windowTicks + 2) {
+        timer = std::thread([this] { run(); });
+    }
+
+    Debouncer(const Debouncer&) = delete;
+    Debouncer& operator=(const Debouncer&) = delete;
+
+    // stops the timer thread, then closes the open windows
+    ~Debouncer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        timer.join();
+        flush();
+    }
+
+    // Called for every restock; delivers it unless the product's window
+    // is open, and returns whether it was delivered
+    bool submit(uint32_t product) {
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        if (!windows.open(product)) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::vector<uint32_t> due;
+        bool wasEmpty;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wasEmpty = wheel.empty();
+            schedule(product, due);
+        }
+        if (wasEmpty) {
+            wakeup.notify_one();
+        }
+        fire(due);
+        if (!deliver(product)) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        delivered.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // closes every open window now, delivering the products restocked
+    // within it
+    void flush() {
+        std::vector<uint32_t> due;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wheel.fireAll([&](uint32_t product) { due.push_back(product); });
+        }
+        for (uint32_t product : due) {
+            if (windows.close(product)) {
+                deliverHeldBack(product);
+            }
+        }
+    }
+
+    Metrics getMetrics() const {
+        Metrics metrics;
+        metrics.submitted = submitted.load(std::memory_order_relaxed);
+        metrics.delivered = delivered.load(std::memory_order_relaxed);
+        metrics.suppressed = suppressed.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        metrics.pending = wheel.size();
+        return metrics;
+    }
+};
+
+#endif // _DEBOUNCER_H_
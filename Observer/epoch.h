@@ -0,0 +1,180 @@
+#ifndef _EPOCH_H_
+#define _EPOCH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Epoch-based reclamation for data that readers access without locks.
+//
+// A reader holds a Guard while it uses shared pointers; the guard
+// announces the global epoch the reader started in. Writers unlink an
+// object and retire() it. The global epoch only advances once every
+// active reader has announced the current one, so an object retired in
+// epoch e cannot be reachable by anyone once the epoch reaches e + 2, and
+// is freed then. Guards nest and cost two stores and a fence.
+class EpochDomain {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr uint64_t QUIESCENT = 0;
+    static constexpr size_t COLLECT_THRESHOLD = 64;
+
+    struct alignas(CACHE_LINE) Record {
+        std::atomic<uint64_t> epoch{QUIESCENT};
+        std::atomic<bool> inUse{true};
+        int nesting = 0;
+    };
+
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        uint64_t epoch;
+    };
+
+    std::atomic<uint64_t> globalEpoch{1};
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Record>> records;
+    std::vector<Retired> retired;
+    // collecting again before the list doubles keeps retire() amortized
+    // O(1) while a slow reader holds the epoch back
+    size_t nextCollect = COLLECT_THRESHOLD;
+
+    // Thread records are reused after their thread exits
+    struct LocalRecord {
+        Record* record = nullptr;
+        ~LocalRecord() {
+            if (record != nullptr) {
+                record->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    Record& localRecord() {
+        thread_local LocalRecord local;
+        if (local.record == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::unique_ptr<Record>& record : records) {
+                bool free = false;
+                if (record->inUse.compare_exchange_strong(free, true)) {
+                    local.record = record.get();
+                    break;
+                }
+            }
+            if (local.record == nullptr) {
+                records.push_back(std::make_unique<Record>());
+                local.record = records.back().get();
+            }
+        }
+        return *local.record;
+    }
+
+    // Caller holds mutex
+    bool tryAdvance() {
+        uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+        for (const std::unique_ptr<Record>& record : records) {
+            uint64_t announced = record->epoch.load(std::memory_order_seq_cst);
+            if (announced != QUIESCENT && announced != epoch) {
+                return false;
+            }
+        }
+        return globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    // Caller holds mutex
+    void collect() {
+        tryAdvance();
+        uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+        size_t kept = 0;
+        for (Retired& item : retired) {
+            if (item.epoch + 2 <= epoch) {
+                item.destroy(item.object);
+            } else {
+                retired[kept++] = item;
+            }
+        }
+        retired.resize(kept);
+        nextCollect = std::max(COLLECT_THRESHOLD, 2 * kept);
+    }
+
+public:
+    static EpochDomain& get() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    ~EpochDomain() {
+        for (Retired& item : retired) {
+            item.destroy(item.object);
+        }
+    }
+
+    class Guard {
+    private:
+        Record& record;
+
+    public:
+        Guard() : record(EpochDomain::get().localRecord()) {
+            if (record.nesting++ == 0) {
+                record.epoch.store(EpochDomain::get().globalEpoch.load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+                // the announcement must be visible before any shared pointer is read
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        ~Guard() {
+            if (--record.nesting == 0) {
+                record.epoch.store(QUIESCENT, std::memory_order_release);
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Frees object once no reader can hold it any more
+    template <typename T>
+    void retire(T* object) {
+        if (object == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        retired.push_back({object, [](void* p) { delete static_cast<T*>(p); },
+                           globalEpoch.load(std::memory_order_acquire)});
+        if (retired.size() >= nextCollect) {
+            collect();
+        }
+    }
+
+    // Waits until every reader that was active when it was called has left
+    // its guard. Must not be called while holding a guard.
+    void synchronize() {
+        uint64_t target = globalEpoch.load(std::memory_order_seq_cst) + 2;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tryAdvance();
+                if (globalEpoch.load(std::memory_order_acquire) >= target) {
+                    collect();
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    bool inReader() {
+        return localRecord().nesting > 0;
+    }
+
+    size_t getRetiredCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return retired.size();
+    }
+};
+
+#endif // _EPOCH_H_
@@ -0,0 +1,361 @@
+#ifndef _EVENTLOG_H_
+#define _EVENTLOG_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Durable, append-only log of stock changes in memory-mapped segments.
+//
+// Every change gets the next sequence number and is written straight into
+// the mapping of the newest segment; when a record no longer fits, a new
+// segment file is started. A record's length is stored last, after its
+// checksum and payload, so readers and crash recovery only ever see
+// complete records. Every segment keeps a sparse index from sequence to
+// offset, and the log keeps the location of the latest record of every
+// product, so replay can start at any sequence or from the current state
+// of every product. Replay hands out views into the mapped segments; it
+// copies nothing and holds no lock while visiting, so it may run next to
+// appends. Appends are serialized by a mutex.
+class EventLog {
+public:
+    struct Options {
+        std::string directory;
+        size_t segmentBytes = size_t(64) << 20;    // kept between 1 MiB and 4 GiB
+    };
+
+    // Valid while the log is open
+    struct Event {
+        uint64_t sequence;
+        int64_t timestampNs;        // system clock
+        uint32_t product;           // id at the time it was written
+        bool inStock;
+        std::string_view productName;
+    };
+
+private:
+    static constexpr char MAGIC[8] = {'S', 'T', 'K', 'L', 'O', 'G', '0', '1'};
+    static constexpr size_t HEADER_BYTES = 64;
+    static constexpr size_t MIN_SEGMENT_BYTES = size_t(1) << 20;
+    // offsets within a segment are stored in 32 bits
+    static constexpr size_t MAX_SEGMENT_BYTES = UINT32_MAX;
+    // one index entry every this many records
+    static constexpr uint64_t INDEX_INTERVAL = 64;
+
+    struct SegmentHeader {
+        char magic[8];
+        uint64_t firstSequence;
+        uint64_t capacity;
+    };
+
+    // length is written last; 0 marks the end of a segment's records
+    struct RecordHeader {
+        uint32_t length;            // whole record padded to 8 bytes
+        uint32_t checksum;          // FNV-1a of everything after it
+        uint64_t sequence;
+        int64_t timestampNs;
+        uint32_t product;
+        uint16_t nameLength;
+        uint8_t inStock;
+        uint8_t reserved;
+    };
+
+    struct Segment {
+        std::string path;
+        char* data = nullptr;
+        size_t capacity = 0;
+        uint64_t firstSequence = 0;
+        size_t end = HEADER_BYTES;      // append position
+        std::vector<std::pair<uint64_t, uint32_t>> index;   // sequence, offset
+
+        Segment(const std::string& path, size_t capacity, uint64_t firstSequence, bool create)
+            : path(path), capacity(capacity), firstSequence(firstSequence) {
+            int fd = open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "EventLog: cannot open " + path);
+            }
+            if (create && ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+                int error = errno;
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "EventLog: cannot size " + path);
+            }
+            void* memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int error = errno;
+            close(fd);
+            if (memory == MAP_FAILED) {
+                throw std::system_error(error, std::generic_category(), "EventLog: cannot map " + path);
+            }
+            data = static_cast<char*>(memory);
+            if (create) {
+                SegmentHeader header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.firstSequence = firstSequence;
+                header.capacity = capacity;
+                std::memcpy(data, &header, sizeof(header));
+            }
+        }
+
+        ~Segment() {
+            munmap(data, capacity);
+        }
+
+        Segment(const Segment&) = delete;
+        Segment& operator=(const Segment&) = delete;
+
+        std::atomic_ref<uint32_t> lengthAt(size_t offset) const {
+            return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(data + offset));
+        }
+
+        // header of the complete record at offset, or null
+        const RecordHeader* recordAt(size_t offset) const {
+            if (offset + sizeof(RecordHeader) > capacity) {
+                return nullptr;
+            }
+            uint32_t length = lengthAt(offset).load(std::memory_order_acquire);
+            if (length < sizeof(RecordHeader) || offset + length > capacity) {
+                return nullptr;
+            }
+            return reinterpret_cast<const RecordHeader*>(data + offset);
+        }
+
+        Event eventAt(const RecordHeader* record) const {
+            const char* name = reinterpret_cast<const char*>(record + 1);
+            return {record->sequence, record->timestampNs, record->product, record->inStock != 0,
+                    std::string_view(name, record->nameLength)};
+        }
+    };
+
+    struct Location {
+        const Segment* segment;
+        uint32_t offset;
+    };
+
+    Options options;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Segment>> segments;
+    uint64_t nextSequence = 1;
+    // keys are views of names inside the segments
+    std::unordered_map<std::string_view, Location> latest;
+
+    static uint32_t checksum(const char* bytes, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    static size_t recordBytes(size_t nameLength) {
+        return (sizeof(RecordHeader) + nameLength + 7) & ~size_t(7);
+    }
+
+    std::string segmentPath(uint64_t firstSequence) const {
+        char name[40];
+        std::snprintf(name, sizeof(name), "events-%020llu.log", static_cast<unsigned long long>(firstSequence));
+        return (std::filesystem::path(options.directory) / name).string();
+    }
+
+    void indexRecord(Segment& segment, const RecordHeader* record, size_t offset) {
+        if ((record->sequence - segment.firstSequence) % INDEX_INTERVAL == 0) {
+            segment.index.emplace_back(record->sequence, static_cast<uint32_t>(offset));
+        }
+        if (record->nameLength > 0) {
+            latest[segment.eventAt(record).productName] = {&segment, static_cast<uint32_t>(offset)};
+        }
+    }
+
+    // Rebuilds the index of a segment found on disk and finds its end; a
+    // torn or corrupt record ends the segment and is wiped
+    void recover(Segment& segment) {
+        size_t offset = HEADER_BYTES;
+        while (const RecordHeader* record = segment.recordAt(offset)) {
+            size_t length = record->length;
+            if (record->sequence != nextSequence
+                || checksum(segment.data + offset + 8, length - 8) != record->checksum) {
+                break;
+            }
+            indexRecord(segment, record, offset);
+            nextSequence++;
+            offset += length;
+        }
+        segment.end = offset;
+        std::memset(segment.data + offset, 0, segment.capacity - offset);
+    }
+
+    void recoverSegments() {
+        std::filesystem::create_directories(options.directory);
+        std::vector<std::pair<uint64_t, std::string>> found;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(options.directory)) {
+            unsigned long long first;
+            if (std::sscanf(entry.path().filename().c_str(), "events-%20llu.log", &first) == 1) {
+                found.emplace_back(first, entry.path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        for (const auto& [first, path] : found) {
+            size_t capacity = std::filesystem::file_size(path);
+            if (capacity < HEADER_BYTES || capacity > MAX_SEGMENT_BYTES) {
+                continue;
+            }
+            auto segment = std::make_unique<Segment>(path, capacity, first, false);
+            if (std::memcmp(segment->data, MAGIC, sizeof(MAGIC)) != 0 || first != nextSequence) {
+                continue;   // not ours, or not contiguous with what came before
+            }
+            recover(*segment);
+            segments.push_back(std::move(segment));
+        }
+    }
+
+    Segment& segmentFor(size_t bytes) {
+        if (segments.empty() || segments.back()->end + bytes > segments.back()->capacity) {
+            if (!segments.empty()) {
+                msync(segments.back()->data, segments.back()->capacity, MS_ASYNC);
+            }
+            size_t capacity = std::max(options.segmentBytes, HEADER_BYTES + bytes);
+            segments.push_back(std::make_unique<Segment>(segmentPath(nextSequence), capacity, nextSequence, true));
+        }
+        return *segments.back();
+    }
+
+public:
+    explicit EventLog(const Options& options) : options(options) {
+        this->options.segmentBytes = std::clamp(options.segmentBytes, MIN_SEGMENT_BYTES, MAX_SEGMENT_BYTES);
+        recoverSegments();
+    }
+
+    ~EventLog() {
+        sync();
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    // Returns the sequence number of the new record, or 0 for a product
+    // without a name, which is not logged: replay finds products by name
+    uint64_t append(uint32_t product, std::string_view productName, bool inStock) {
+        if (productName.empty()) {
+            return 0;
+        }
+        productName = productName.substr(0, UINT16_MAX);
+        size_t length = recordBytes(productName.size());
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Segment& segment = segmentFor(length);
+        size_t offset = segment.end;
+        RecordHeader header{0, 0, nextSequence, now, product, static_cast<uint16_t>(productName.size()),
+                            static_cast<uint8_t>(inStock ? 1 : 0), 0};
+        char* record = segment.data + offset;
+        std::memcpy(record + 8, reinterpret_cast<const char*>(&header) + 8, sizeof(header) - 8);
+        std::memcpy(record + sizeof(header), productName.data(), productName.size());
+        std::memset(record + sizeof(header) + productName.size(), 0, length - sizeof(header) - productName.size());
+        header.checksum = checksum(record + 8, length - 8);
+        std::memcpy(record + 4, &header.checksum, sizeof(header.checksum));
+        segment.lengthAt(offset).store(static_cast<uint32_t>(length), std::memory_order_release);
+
+        segment.end += length;
+        indexRecord(segment, reinterpret_cast<const RecordHeader*>(record), offset);
+        return nextSequence++;
+    }
+
+    // Calls visit(event) for every event from sequence fromSequence up to
+    // the last one appended before the call, and returns the sequence to
+    // continue from
+    template <typename Visit>
+    uint64_t replay(uint64_t fromSequence, Visit visit) const {
+        std::vector<const Segment*> visible;
+        size_t offset = HEADER_BYTES;
+        uint64_t last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = nextSequence - 1;
+            // the last segment starting at or before fromSequence
+            auto first = std::upper_bound(segments.begin(), segments.end(), fromSequence,
+                                          [](uint64_t sequence, const std::unique_ptr<Segment>& segment) {
+                                              return sequence < segment->firstSequence;
+                                          });
+            if (first != segments.begin()) {
+                --first;
+                const std::vector<std::pair<uint64_t, uint32_t>>& index = (*first)->index;
+                auto entry = std::upper_bound(index.begin(), index.end(), std::make_pair(fromSequence, UINT32_MAX));
+                if (entry != index.begin()) {
+                    offset = std::prev(entry)->second;
+                }
+            }
+            for (auto it = first; it != segments.end(); ++it) {
+                visible.push_back(it->get());
+            }
+        }
+
+        uint64_t next = std::max(fromSequence, uint64_t(1));
+        for (const Segment* segment : visible) {
+            while (const RecordHeader* record = segment->recordAt(offset)) {
+                if (record->sequence > last) {
+                    return next;
+                }
+                if (record->sequence >= fromSequence) {
+                    visit(segment->eventAt(record));
+                    next = record->sequence + 1;
+                }
+                offset += record->length;
+            }
+            offset = HEADER_BYTES;
+        }
+        return next;
+    }
+
+    // Calls visit(event) with the latest event of every named product,
+    // in no particular order, and returns how many there were
+    template <typename Visit>
+    size_t replayLatest(Visit visit) const {
+        std::vector<Location> locations;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            locations.reserve(latest.size());
+            for (const auto& [name, location] : latest) {
+                locations.push_back(location);
+            }
+        }
+        for (const Location& location : locations) {
+            visit(location.segment->eventAt(location.segment->recordAt(location.offset)));
+        }
+        return locations.size();
+    }
+
+    // Flushes every segment to disk
+    void sync() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::unique_ptr<Segment>& segment : segments) {
+            msync(segment->data, segment->end, MS_SYNC);
+        }
+    }
+
+    uint64_t getLastSequence() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return nextSequence - 1;
+    }
+
+    size_t getSegmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segments.size();
+    }
+};
+
+#endif // _EVENTLOG_H_
@@ -0,0 +1,96 @@
+#ifndef _EVENTQUEUE_H_
+#define _EVENTQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov's ring).
+//
+// Every cell carries a sequence number that tells producers and consumers
+// whose turn it is, so a push or pop is one CAS on the shared position
+// plus a store to the cell; no thread ever waits for another one inside
+// the queue. tryPush() fails when the queue is full, tryPop() when it is
+// empty. The capacity is rounded up to a power of two.
+template <typename T>
+class EventQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(CACHE_LINE) std::atomic<size_t> enqueuePosition{0};
+    alignas(CACHE_LINE) std::atomic<size_t> dequeuePosition{0};
+
+public:
+    explicit EventQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // approximate while other threads push or pop
+    size_t size() const {
+        size_t tail = enqueuePosition.load(std::memory_order_relaxed);
+        size_t head = dequeuePosition.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool tryPush(const T& value) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;   // full
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;   // empty
+            } else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif // _EVENTQUEUE_H_
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latencyhistogram.h"
+#include "observer.h"
+#include "stockmanager.h"
+
+// Fan-out cost of notifying 1K to 10M observers whose interests follow a
+// Zipf distribution over the products, for three dispatch modes:
+//
+//   vector   every observer registered in one vector and called for every
+//            product, as in stockmanager_observer.cpp
+//   indexed  StockManager subscriptions, delivered on the caller's thread
+//   async    StockManager subscriptions, delivered by an AsyncDispatcher
+//
+// Latency is per notification: the notifyObservers() call for the
+// synchronous modes, publish to delivery for async. Allocations are
+// counted by replacing the global operator new.
+//
+// usage: fanout_benchmark [max observers] [products] [interests] [zipf s] [ms per run]
+
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+class CountingObserver : public Observer {
+public:
+    std::atomic<uint64_t> updates{0};
+
+    void update(const std::string&) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// the subject of stockmanager_observer.cpp: everybody hears about everything
+class VectorSubject {
+private:
+    std::vector<Observer*> observers;
+
+public:
+    void registerObserver(Observer* observer) {
+        observers.push_back(observer);
+    }
+
+    void notifyObservers(const std::string& productName) {
+        for (Observer* observer : observers) {
+            observer->update(productName);
+        }
+    }
+};
+
+// draws product ranks with probability proportional to 1 / (rank + 1)^s
+class Zipf {
+private:
+    std::vector<double> cumulative;
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+
+public:
+    Zipf(uint32_t products, double s) : cumulative(products) {
+        double total = 0.0;
+        for (uint32_t r = 0; r < products; r++) {
+            total += 1.0 / std::pow(r + 1.0, s);
+            cumulative[r] = total;
+        }
+        for (double& c : cumulative) {
+            c /= total;
+        }
+    }
+
+    uint32_t operator()(std::mt19937_64& random) {
+        auto it = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random));
+        return static_cast<uint32_t>(std::min<size_t>(it - cumulative.begin(), cumulative.size() - 1));
+    }
+};
+
+struct Result {
+    uint64_t notifications = 0;
+    uint64_t updates = 0;
+    double seconds = 0.0;
+    uint64_t allocations = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t totalUpdates(const std::vector<CountingObserver>& customers) {
+    uint64_t total = 0;
+    for (const CountingObserver& customer : customers) {
+        total += customer.updates.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// calls notify(product) for random products until the time is up
+template <typename Notify>
+Result runSynchronous(const std::vector<uint32_t>& events, int milliseconds, Notify notify) {
+    LatencyHistogram latency;
+    Result result;
+    uint64_t allocated = allocations.load();
+    int64_t start = nowNs();
+    int64_t end = start + int64_t(milliseconds) * 1000000;
+    int64_t now = start;
+    while (now < end) {
+        uint32_t product = events[result.notifications % events.size()];
+        notify(product);
+        int64_t after = nowNs();
+        latency.record(static_cast<uint64_t>(after - now));
+        now = after;
+        result.notifications++;
+    }
+    result.seconds = (now - start) / 1e9;
+    result.allocations = allocations.load() - allocated;
+    result.p50Ns = latency.percentile(0.50);
+    result.p99Ns = latency.percentile(0.99);
+    result.p999Ns = latency.percentile(0.999);
+    result.maxNs = latency.getMax();
+    return result;
+}
+
+static void print(uint64_t observers, const std::string& mode, const Result& result) {
+    double notifications = static_cast<double>(std::max<uint64_t>(result.notifications, 1));
+    std::cout << std::setw(10) << observers << std::setw(9) << mode << std::fixed << std::setprecision(0)
+              << std::setw(13) << result.notifications / result.seconds
+              << std::setw(14) << result.updates / result.seconds
+              << std::setprecision(1)
+              << std::setw(11) << result.p50Ns / 1000.0 << std::setw(11) << result.p99Ns / 1000.0
+              << std::setw(11) << result.p999Ns / 1000.0 << std::setw(11) << result.maxNs / 1000.0
+              << std::setprecision(3) << std::setw(15) << result.allocations / notifications << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t maxObservers = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    uint32_t products = argc > 2 ? std::stoul(argv[2]) : 10000;
+    unsigned interests = argc > 3 ? std::stoul(argv[3]) : 3;
+    double s = argc > 4 ? std::stod(argv[4]) : 1.0;
+    int milliseconds = argc > 5 ? std::stoi(argv[5]) : 500;
+
+    std::vector<std::string> names;
+    for (uint32_t p = 0; p < products; p++) {
+        names.push_back("SKU-" + std::to_string(p));
+    }
+    std::mt19937_64 random(11);
+    Zipf zipf(products, s);
+    // restocks hit products uniformly
+    std::vector<uint32_t> events(1 << 16);
+    for (uint32_t& event : events) {
+        event = static_cast<uint32_t>(random() % products);
+    }
+
+    std::cout << products << " products, " << interests << " interests per observer, zipf s = " << s << "\n\n";
+    std::cout << std::setw(10) << "observers" << std::setw(9) << "mode" << std::setw(13) << "notify/s"
+              << std::setw(14) << "updates/s" << std::setw(11) << "p50 us" << std::setw(11) << "p99 us"
+              << std::setw(11) << "p999 us" << std::setw(11) << "max us" << std::setw(15) << "allocs/notify"
+              << std::endl;
+
+    for (uint64_t observers = 1000; observers <= maxObservers; observers *= 10) {
+        std::vector<CountingObserver> customers(observers);
+        {
+            VectorSubject subject;
+            for (CountingObserver& customer : customers) {
+                subject.registerObserver(&customer);
+            }
+            Result result = runSynchronous(events, milliseconds,
+                                           [&](uint32_t product) { subject.notifyObservers(names[product]); });
+            result.updates = totalUpdates(customers);
+            print(observers, "vector", result);
+        }
+
+        for (bool async : {false, true}) {
+            for (CountingObserver& customer : customers) {
+                customer.updates.store(0, std::memory_order_relaxed);
+            }
+            StockManager stockManager;
+            for (const std::string& name : names) {
+                stockManager.getProductId(name);
+            }
+            for (CountingObserver& customer : customers) {
+                for (unsigned i = 0; i < interests; i++) {
+                    stockManager.subscribe(&customer, zipf(random));
+                }
+            }
+
+            Result result;
+            if (!async) {
+                result = runSynchronous(events, milliseconds,
+                                        [&](uint32_t product) { stockManager.notifyObservers(product); });
+            } else {
+                AsyncDispatcher::Options options;
+                options.threads = std::max(1u, std::thread::hardware_concurrency());
+                stockManager.startDispatcher(options);
+                uint64_t allocated = allocations.load();
+                int64_t start = nowNs();
+                int64_t end = start + int64_t(milliseconds) * 1000000;
+                for (uint64_t e = 0; nowNs() < end; e++) {
+                    uint32_t product = events[e % events.size()];
+                    stockManager.setStockStatus(false, product);
+                    stockManager.setStockStatus(true, product);
+                }
+                stockManager.flushNotifications();
+                result.seconds = (nowNs() - start) / 1e9;
+                result.allocations = allocations.load() - allocated;
+                AsyncDispatcher::Metrics metrics = stockManager.getDispatcherMetrics();
+                result.notifications = metrics.delivered;
+                result.p50Ns = metrics.p50LatencyNs;
+                result.p99Ns = metrics.p99LatencyNs;
+                result.p999Ns = metrics.p999LatencyNs;
+                result.maxNs = metrics.maxLatencyNs;
+                stockManager.stopDispatcher();
+            }
+            result.updates = totalUpdates(customers);
+            print(observers, async ? "async" : "indexed", result);
+        }
+    }
+    return 0;
+}
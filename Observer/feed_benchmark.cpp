@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "observer.h"
+#include "stockfeed.h"
+#include "stockmanager.h"
+
+// Ingest throughput of a stock feed read line by line into std::strings
+// and applied through setStockStatus(), against StockFeed on the same
+// feed, as CSV and as fixed-width binary records.
+//
+// usage: feed_benchmark [records] [products] [directory]
+
+class CountingObserver : public Observer {
+public:
+    std::atomic<uint64_t> updates{0};
+
+    void update(const std::string&) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+static std::string productName(uint32_t product) {
+    return "SKU-" + std::to_string(product);
+}
+
+static void writeFeeds(const std::string& csvPath, const std::string& binaryPath, uint64_t records,
+                       uint32_t products) {
+    std::ofstream csv(csvPath, std::ios::binary);
+    std::ofstream binary(binaryPath, std::ios::binary);
+    std::mt19937 random(7);
+    for (uint64_t r = 0; r < records; r++) {
+        uint32_t product = random() % products;
+        bool inStock = random() % 2 == 0;
+        csv << productName(product) << ',' << (inStock ? '1' : '0') << '\n';
+        StockFeed::BinaryRecord record{product, inStock ? 1u : 0u};
+        binary.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+}
+
+// products are added in id order, so binary ids match the CSV names
+static void setUp(StockManager& stockManager, CountingObserver& customer, uint32_t products) {
+    for (uint32_t p = 0; p < products; p++) {
+        stockManager.subscribe(&customer, stockManager.getProductId(productName(p)));
+    }
+}
+
+static void print(const std::string& name, const StockFeed::Stats& stats, uint64_t notified) {
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << stats.recordsPerSecond() << std::setw(12) << stats.records
+              << std::setw(12) << stats.restocked << std::setw(12) << notified << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t records = argc > 1 ? std::stoull(argv[1]) : 5000000;
+    uint32_t products = argc > 2 ? std::stoul(argv[2]) : 100000;
+    std::string directory = argc > 3 ? argv[3] : "/tmp";
+    std::string csvPath = directory + "/stock_feed.csv";
+    std::string binaryPath = directory + "/stock_feed.bin";
+
+    writeFeeds(csvPath, binaryPath, records, products);
+    std::cout << records << " records on " << products << " products\n\n";
+    std::cout << std::left << std::setw(22) << "path" << std::right << std::setw(14) << "records/s"
+              << std::setw(12) << "records" << std::setw(12) << "restocked" << std::setw(12) << "notified" << '\n';
+
+    {
+        StockManager stockManager;
+        CountingObserver customer;
+        setUp(stockManager, customer, products);
+        StockFeed::Stats stats;
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream csv(csvPath);
+        std::string line;
+        while (std::getline(csv, line)) {
+            size_t comma = line.rfind(',');
+            if (stockManager.setStockStatus(line[comma + 1] == '1', line.substr(0, comma))) {
+                stats.restocked++;
+            }
+            stats.records++;
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        print("setStockStatus", stats, customer.updates.load());
+    }
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (StockFeed::Format format : {StockFeed::Format::Csv, StockFeed::Format::Binary}) {
+        for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+            StockManager stockManager;
+            CountingObserver customer;
+            setUp(stockManager, customer, products);
+            StockFeed feed(stockManager, threads);
+            StockFeed::Stats stats = format == StockFeed::Format::Csv ? feed.ingest(csvPath, format)
+                                                                       : feed.ingest(binaryPath, format);
+            std::string name = std::string(format == StockFeed::Format::Csv ? "StockFeed csv" : "StockFeed binary")
+                + " x" + std::to_string(threads);
+            print(name, stats, customer.updates.load());
+        }
+    }
+
+    std::remove(csvPath.c_str());
+    std::remove(binaryPath.c_str());
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef _LATENCYHISTOGRAM_H_
+#define _LATENCYHISTOGRAM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free histogram of latencies in nanoseconds, laid out like an HDR
+// histogram: every power of two is split into 32 linear sub-buckets, so
+// values below 64 ns are exact and every other value, and every
+// percentile, is reported within 1/32 (about 3%) of the real one. A
+// record is three relaxed atomic adds and needs no allocation.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 6;
+    static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;    // exact values
+    static constexpr uint64_t HALF = SUB_COUNT / 2;                     // sub-buckets per power of two
+    static constexpr int BUCKETS = SUB_COUNT + (64 - SUB_BITS) * HALF;
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < SUB_COUNT) {
+            return static_cast<int>(ns);
+        }
+        int shift = 64 - __builtin_clzll(ns) - SUB_BITS;
+        return static_cast<int>(SUB_COUNT + (shift - 1) * HALF + ((ns >> shift) - HALF));
+    }
+
+    // highest value that falls into bucket
+    static uint64_t upperBound(int bucket) {
+        if (bucket < static_cast<int>(SUB_COUNT)) {
+            return bucket;
+        }
+        int shift = (bucket - SUB_COUNT) / HALF + 1;
+        uint64_t top = (bucket - SUB_COUNT) % HALF + HALF;
+        return shift + SUB_BITS >= 64 && top == SUB_COUNT - 1 ? UINT64_MAX : ((top + 1) << shift) - 1;
+    }
+
+    void raiseMax(uint64_t ns) {
+        uint64_t seen = max.load(std::memory_order_relaxed);
+        while (ns > seen && !max.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+public:
+    void record(uint64_t ns) {
+        buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ns, std::memory_order_relaxed);
+        raiseMax(ns);
+    }
+
+    // adds the samples of other, e.g. of a per-thread histogram
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < BUCKETS; b++) {
+            uint64_t n = other.buckets[b].load(std::memory_order_relaxed);
+            if (n != 0) {
+                buckets[b].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        count.fetch_add(other.getCount(), std::memory_order_relaxed);
+        sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        raiseMax(other.getMax());
+    }
+
+    uint64_t getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getMax() const {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    double getMean() const {
+        uint64_t n = getCount();
+        return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+    }
+
+    // latency below which a fraction q of the samples fall
+    uint64_t percentile(double q) const {
+        uint64_t n = getCount();
+        uint64_t rank = static_cast<uint64_t>(q * n);
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                return std::min(upperBound(b), getMax());
+            }
+        }
+        return getMax();
+    }
+};
+
+#endif // _LATENCYHISTOGRAM_H_
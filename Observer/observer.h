@@ -0,0 +1,29 @@
+#ifndef _OBSERVER_H_
+#define _OBSERVER_H_
+
+#include <string>
+
+// Forward declaration of Observer interface
+class Observer;
+
+// Subject interface
+class Subject {
+public:
+    virtual ~Subject() {}
+    // Observers registered here are notified about every product
+    virtual void registerObserver(Observer* observer) = 0;
+    virtual void removeObserver(Observer* observer) = 0;
+    // Observers subscribed to a product are notified only about that product
+    virtual void subscribe(Observer* observer, const std::string& productName) = 0;
+    virtual void unsubscribe(Observer* observer, const std::string& productName) = 0;
+    virtual void notifyObservers(const std::string& productName) = 0;
+};
+
+// Observer interface
+class Observer {
+public:
+    virtual ~Observer() {}
+    virtual void update(const std::string& productName) = 0;
+};
+
+#endif // _OBSERVER_H_
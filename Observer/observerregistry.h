@@ -0,0 +1,372 @@
+#ifndef _OBSERVERREGISTRY_H_
+#define _OBSERVERREGISTRY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "epoch.h"
+#include "observer.h"
+#include "slotmap.h"
+
+// Observer registry that notifiers read without taking any lock.
+//
+// Every subscription lives in a slot map and is addressed by a handle, so
+// cancelling one is O(1) and a stale handle is detected by its
+// generation. Every product has a slot with its name and a list of
+// subscribers, and wildcard observers have a list of their own. Slots
+// live in fixed-size chunks that are never moved, so a product id
+// resolves to its slot with two loads while new products are being
+// added. All modifying calls must be serialized by the caller.
+class ObserverRegistry {
+public:
+    using ProductId = uint32_t;
+
+    struct Subscription {
+        Observer* observer;
+        ProductId product;
+        uint32_t position;      // entry in the subscriber list
+    };
+
+    using Handle = SlotMap<Subscription>::Handle;
+
+    // subscribes to every product
+    static constexpr ProductId ALL_PRODUCTS = UINT32_MAX;
+
+    static constexpr uint32_t CHUNK_SIZE = 4096;
+    static constexpr uint32_t CHUNKS = 16384;
+    static constexpr uint64_t MAX_PRODUCTS = uint64_t(CHUNK_SIZE) * CHUNKS;
+
+private:
+    // Contiguous array of subscribers that readers walk without locks.
+    //
+    // Subscribing appends and publishes the new size; cancelling only
+    // clears the entry, so an entry never moves under a reader and nobody
+    // who stays subscribed is skipped or visited twice. Once more than half
+    // of the entries are cleared, or the array is full, the live ones are
+    // copied into a new array that is published atomically while the old
+    // one is retired through the epoch domain. Each copy is paid for by as
+    // many earlier changes, so both operations are amortized O(1).
+    //
+    // Most products have only a subscriber or two, so the first array lives
+    // inside the list itself and a product needs no allocation of its own
+    // until it outgrows it. A list that spilled to the heap goes back to the
+    // inline array only once it is empty: any reader still walking the
+    // inline array then saw nobody who stayed subscribed.
+    class SubscriberList {
+    private:
+        static constexpr uint32_t INLINE_CAPACITY = 2;
+        static constexpr uint32_t MIN_CAPACITY = 4;
+
+        // one allocation: the header, the entries, then the owner of each
+        struct Block {
+            uint32_t capacity;
+            std::atomic<uint32_t> size{0};
+
+            explicit Block(uint32_t capacity) : capacity(capacity) {}
+
+            static Block* create(uint32_t capacity) {
+                void* memory = ::operator new(sizeof(Block)
+                                              + capacity * (sizeof(std::atomic<Observer*>) + sizeof(Handle)));
+                Block* block = new (memory) Block(capacity);
+                for (uint32_t i = 0; i < capacity; i++) {
+                    new (&block->entries()[i]) std::atomic<Observer*>(nullptr);
+                }
+                return block;
+            }
+
+            static void operator delete(void* memory) {
+                ::operator delete(memory);
+            }
+
+            std::atomic<Observer*>* entries() {
+                return reinterpret_cast<std::atomic<Observer*>*>(this + 1);
+            }
+
+            const std::atomic<Observer*>* entries() const {
+                return reinterpret_cast<const std::atomic<Observer*>*>(this + 1);
+            }
+
+            Handle* owners() {
+                return reinterpret_cast<Handle*>(entries() + capacity);
+            }
+
+            const Handle* owners() const {
+                return reinterpret_cast<const Handle*>(entries() + capacity);
+            }
+        };
+
+        // laid out exactly like a Block of INLINE_CAPACITY entries
+        struct InlineBlock {
+            Block header{INLINE_CAPACITY};
+            std::atomic<Observer*> entries[INLINE_CAPACITY]{};
+            Handle owners[INLINE_CAPACITY];
+        };
+
+        InlineBlock small;
+        std::atomic<Block*> current{&small.header};
+        std::atomic<uint32_t> live{0};
+
+        static_assert(offsetof(InlineBlock, entries) == sizeof(Block));
+        static_assert(offsetof(InlineBlock, owners) == sizeof(Block) + sizeof(InlineBlock::entries));
+
+        bool isInline(const Block* block) const {
+            return block == &small.header;
+        }
+
+        // relocate(owner, position) is told where every live entry went
+        template <typename Relocate>
+        void rebuild(uint32_t capacity, Relocate relocate) {
+            Block* old = current.load(std::memory_order_relaxed);
+            Block* next = &small.header;
+            if (capacity == 0) {
+                // nobody is left, so the inline array can be taken back
+                if (!isInline(old)) {
+                    for (uint32_t i = 0; i < INLINE_CAPACITY; i++) {
+                        small.entries[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+                small.header.size.store(0, std::memory_order_release);
+            } else {
+                next = Block::create(capacity);
+                uint32_t size = old->size.load(std::memory_order_relaxed);
+                uint32_t kept = 0;
+                for (uint32_t i = 0; i < size; i++) {
+                    Observer* observer = old->entries()[i].load(std::memory_order_relaxed);
+                    if (observer != nullptr) {
+                        next->entries()[kept].store(observer, std::memory_order_relaxed);
+                        next->owners()[kept] = old->owners()[i];
+                        relocate(old->owners()[i], kept);
+                        kept++;
+                    }
+                }
+                next->size.store(kept, std::memory_order_relaxed);
+            }
+            current.store(next, std::memory_order_release);
+            if (!isInline(old)) {
+                EpochDomain::get().retire(old);
+            }
+        }
+
+    public:
+        SubscriberList() = default;
+        SubscriberList(const SubscriberList&) = delete;
+        SubscriberList& operator=(const SubscriberList&) = delete;
+
+        // no reader may be left when a list is destroyed
+        ~SubscriberList() {
+            Block* block = current.load(std::memory_order_relaxed);
+            if (!isInline(block)) {
+                delete block;
+            }
+        }
+
+        size_t size() const {
+            return live.load(std::memory_order_relaxed);
+        }
+
+        // Readers must hold an EpochDomain::Guard
+        template <typename Visit>
+        void forEach(Visit visit) const {
+            const Block* block = current.load(std::memory_order_acquire);
+            uint32_t size = block->size.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < size; i++) {
+                Observer* observer = block->entries()[i].load(std::memory_order_acquire);
+                if (observer != nullptr) {
+                    visit(observer);
+                }
+            }
+        }
+
+        // Writers only; an invalid handle if observer is not on the list
+        Handle find(Observer* observer) const {
+            const Block* block = current.load(std::memory_order_relaxed);
+            uint32_t size = block->size.load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < size; i++) {
+                if (block->entries()[i].load(std::memory_order_relaxed) == observer) {
+                    return block->owners()[i];
+                }
+            }
+            return Handle();
+        }
+
+        // Returns the position of the new entry
+        template <typename Relocate>
+        uint32_t add(Observer* observer, Handle owner, Relocate relocate) {
+            uint32_t count = live.load(std::memory_order_relaxed);
+            Block* block = current.load(std::memory_order_relaxed);
+            if (block->size.load(std::memory_order_relaxed) == block->capacity) {
+                rebuild(std::max(MIN_CAPACITY, 2 * (count + 1)), relocate);
+                block = current.load(std::memory_order_relaxed);
+            }
+            uint32_t position = block->size.load(std::memory_order_relaxed);
+            block->owners()[position] = owner;
+            block->entries()[position].store(observer, std::memory_order_release);
+            block->size.store(position + 1, std::memory_order_release);
+            live.store(count + 1, std::memory_order_relaxed);
+            return position;
+        }
+
+        template <typename Relocate>
+        void remove(uint32_t position, Relocate relocate) {
+            Block* block = current.load(std::memory_order_relaxed);
+            block->entries()[position].store(nullptr, std::memory_order_release);
+            uint32_t count = live.load(std::memory_order_relaxed) - 1;
+            live.store(count, std::memory_order_relaxed);
+            uint32_t size = block->size.load(std::memory_order_relaxed);
+            if (count == 0) {
+                rebuild(0, relocate);
+            } else if (size > MIN_CAPACITY && size - count > count) {
+                rebuild(std::max(MIN_CAPACITY, 2 * count), relocate);
+            }
+        }
+    };
+
+    struct Product {
+        std::string name;
+        SubscriberList subscribers;
+    };
+
+    using Chunk = Product[CHUNK_SIZE];
+
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks{new std::atomic<Chunk*>[CHUNKS]()};
+    // slots below this are initialized and visible to readers
+    std::atomic<uint32_t> productCount{0};
+    SubscriberList observers;
+    SlotMap<Subscription> subscriptions;
+
+    Product* find(ProductId product) const {
+        if (product >= productCount.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Chunk* chunk = chunks[product / CHUNK_SIZE].load(std::memory_order_acquire);
+        return &(*chunk)[product % CHUNK_SIZE];
+    }
+
+    SubscriberList* listOf(ProductId product) {
+        if (product == ALL_PRODUCTS) {
+            return &observers;
+        }
+        Product* slot = find(product);
+        return slot != nullptr ? &slot->subscribers : nullptr;
+    }
+
+    const SubscriberList* listOf(ProductId product) const {
+        return const_cast<ObserverRegistry*>(this)->listOf(product);
+    }
+
+    auto relocator() {
+        return [this](Handle owner, uint32_t position) { subscriptions.find(owner)->position = position; };
+    }
+
+public:
+    ObserverRegistry() = default;
+    ObserverRegistry(const ObserverRegistry&) = delete;
+    ObserverRegistry& operator=(const ObserverRegistry&) = delete;
+
+    ~ObserverRegistry() {
+        for (uint32_t c = 0; c < CHUNKS; c++) {
+            delete[] chunks[c].load(std::memory_order_relaxed);
+        }
+    }
+
+    ProductId addProduct(const std::string& productName) {
+        uint32_t product = productCount.load(std::memory_order_relaxed);
+        if (product >= MAX_PRODUCTS) {
+            throw std::length_error("ObserverRegistry: too many products");
+        }
+        std::atomic<Chunk*>& slot = chunks[product / CHUNK_SIZE];
+        if (slot.load(std::memory_order_relaxed) == nullptr) {
+            slot.store(new Chunk[1], std::memory_order_release);
+        }
+        (*slot.load(std::memory_order_relaxed))[product % CHUNK_SIZE].name = productName;
+        productCount.store(product + 1, std::memory_order_release);
+        return product;
+    }
+
+    size_t getProductCount() const {
+        return productCount.load(std::memory_order_acquire);
+    }
+
+    // empty for ids that were never added
+    std::string getProductName(ProductId product) const {
+        return std::string(getProductNameView(product));
+    }
+
+    // names never change or move once added, so the view stays valid for
+    // the lifetime of the registry
+    std::string_view getProductNameView(ProductId product) const {
+        const Product* slot = find(product);
+        return slot != nullptr ? std::string_view(slot->name) : std::string_view();
+    }
+
+    // ALL_PRODUCTS counts the wildcard observers
+    size_t getSubscriberCount(ProductId product) const {
+        const SubscriberList* list = listOf(product);
+        return list != nullptr ? list->size() : 0;
+    }
+
+    // Returns an invalid handle if product was never added
+    Handle subscribe(Observer* observer, ProductId product) {
+        SubscriberList* list = listOf(product);
+        if (list == nullptr) {
+            return Handle();
+        }
+        Handle handle = subscriptions.insert({observer, product, 0});
+        uint32_t position = list->add(observer, handle, relocator());
+        subscriptions.find(handle)->position = position;
+        return handle;
+    }
+
+    // O(1); false for stale handles
+    bool unsubscribe(Handle handle) {
+        const Subscription* subscription = subscriptions.find(handle);
+        if (subscription == nullptr) {
+            return false;
+        }
+        SubscriberList* list = listOf(subscription->product);
+        uint32_t position = subscription->position;
+        subscriptions.erase(handle);
+        list->remove(position, relocator());
+        return true;
+    }
+
+    // null for stale handles
+    const Subscription* find(Handle handle) const {
+        return subscriptions.find(handle);
+    }
+
+    // Scans the subscribers of product; an invalid handle if observer is
+    // not among them
+    Handle find(Observer* observer, ProductId product) const {
+        const SubscriberList* list = listOf(product);
+        return list != nullptr ? list->find(observer) : Handle();
+    }
+
+    size_t getSubscriptionCount() const {
+        return subscriptions.size();
+    }
+
+    // Calls visit(productName, observer) for the subscribers of product and
+    // then for every wildcard observer. Lock-free, and safe while other
+    // threads change subscriptions; an observer that stays subscribed the
+    // whole time is visited exactly once.
+    template <typename Visit>
+    void forEachObserver(ProductId product, Visit visit) const {
+        EpochDomain::Guard guard;
+        const Product* slot = find(product);
+        if (slot == nullptr) {
+            return;
+        }
+        slot->subscribers.forEach([&](Observer* observer) { visit(slot->name, observer); });
+        observers.forEach([&](Observer* observer) { visit(slot->name, observer); });
+    }
+};
+
+#endif // _OBSERVERREGISTRY_H_
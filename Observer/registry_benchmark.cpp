@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observer.h"
+#include "stockmanager.h"
+
+// Notify throughput while other threads keep subscribing and
+// unsubscribing, for the lock-free registry of StockManager and for
+// the reader-writer locked registry it replaced. Churn cancels through the
+// handle returned by subscribe().
+//
+// usage: registry_benchmark [notifiers] [churners] [products] [milliseconds]
+
+class CountingObserver : public Observer {
+public:
+    std::atomic<uint64_t> updates{0};
+
+    void update(const std::string&) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// inverted index behind a shared_mutex, read locked while notifying
+class LockedRegistry {
+public:
+    using Token = std::pair<Observer*, uint32_t>;
+
+private:
+    std::vector<std::vector<Observer*>> subscribers;
+    std::vector<std::string> productNames;
+    mutable std::shared_mutex mutex;
+
+public:
+    explicit LockedRegistry(uint32_t products) : subscribers(products) {
+        for (uint32_t p = 0; p < products; p++) {
+            productNames.push_back("Product " + std::to_string(p));
+        }
+    }
+
+    Token subscribe(Observer* observer, uint32_t product) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        std::vector<Observer*>& list = subscribers[product];
+        if (std::find(list.begin(), list.end(), observer) == list.end()) {
+            list.push_back(observer);
+        }
+        return {observer, product};
+    }
+
+    void unsubscribe(Token token) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        std::vector<Observer*>& list = subscribers[token.second];
+        auto it = std::find(list.begin(), list.end(), token.first);
+        if (it != list.end()) {
+            list.erase(it);
+        }
+    }
+
+    void notifyObservers(uint32_t product) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (Observer* observer : subscribers[product]) {
+            observer->update(productNames[product]);
+        }
+    }
+};
+
+class LockFreeRegistry {
+private:
+    StockManager stockManager;
+
+public:
+    explicit LockFreeRegistry(uint32_t products) {
+        for (uint32_t p = 0; p < products; p++) {
+            stockManager.getProductId("Product " + std::to_string(p));
+        }
+    }
+
+    using Token = StockManager::SubscriptionHandle;
+
+    Token subscribe(Observer* observer, uint32_t product) {
+        return stockManager.subscribe(observer, product);
+    }
+
+    void unsubscribe(Token token) {
+        stockManager.unsubscribe(token);
+    }
+
+    void notifyObservers(uint32_t product) {
+        stockManager.notifyObservers(product);
+    }
+};
+
+struct Result {
+    double notifiesPerSecond;
+    double churnPerSecond;
+};
+
+template <typename Registry>
+Result run(unsigned notifiers, unsigned churners, uint32_t products, int milliseconds) {
+    Registry registry(products);
+    std::vector<CountingObserver> customers(64);
+    // every product starts with a few subscribers
+    std::mt19937 seed(42);
+    for (uint32_t p = 0; p < products; p++) {
+        for (int s = 0; s < 4; s++) {
+            registry.subscribe(&customers[seed() % customers.size()], p);
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> notifies{0};
+    std::atomic<uint64_t> changes{0};
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < notifiers; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 random(1000 + t);
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                registry.notifyObservers(random() % products);
+                count++;
+            }
+            notifies.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+    for (unsigned t = 0; t < churners; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 random(2000 + t);
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                Observer* customer = &customers[random() % customers.size()];
+                uint32_t product = random() % products;
+                registry.unsubscribe(registry.subscribe(customer, product));
+                count += 2;
+            }
+            changes.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    double seconds = milliseconds / 1000.0;
+    return {notifies.load() / seconds, changes.load() / seconds};
+}
+
+int main(int argc, char* argv[]) {
+    unsigned notifiers = argc > 1 ? std::stoul(argv[1]) : 4;
+    unsigned maxChurners = argc > 2 ? std::stoul(argv[2]) : 4;
+    uint32_t products = argc > 3 ? std::stoul(argv[3]) : 10000;
+    int milliseconds = argc > 4 ? std::stoi(argv[4]) : 500;
+
+    std::cout << notifiers << " notifying threads, " << products << " products\n\n";
+    std::cout << std::setw(9) << "churners" << std::setw(18) << "locked notify/s" << std::setw(20) << "lock-free notify/s"
+              << std::setw(18) << "locked changes/s" << std::setw(20) << "lock-free changes/s" << '\n';
+    for (unsigned churners = 0; churners <= maxChurners; churners = churners == 0 ? 1 : churners * 2) {
+        Result locked = run<LockedRegistry>(notifiers, churners, products, milliseconds);
+        Result lockFree = run<LockFreeRegistry>(notifiers, churners, products, milliseconds);
+        std::cout << std::fixed << std::setprecision(0) << std::setw(9) << churners
+                  << std::setw(18) << locked.notifiesPerSecond << std::setw(20) << lockFree.notifiesPerSecond
+                  << std::setw(18) << locked.churnPerSecond << std::setw(20) << lockFree.churnPerSecond << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#ifndef _SLOTMAP_H_
+#define _SLOTMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Values addressed by stable handles, stored densely.
+//
+// A handle names a slot and the generation the slot had when the value
+// was inserted. Erasing bumps the generation, so a stale handle is
+// recognised with one compare even after its slot was reused. The values
+// themselves are kept in one contiguous array: erase() moves the last
+// value into the gap, so insert, erase and lookup are all O(1) and
+// iteration never skips holes. Order is not kept.
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle& other) const = default;
+    };
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Slot {
+        uint32_t dense;         // position in values, or next free slot
+        uint32_t generation;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<T> values;
+    std::vector<uint32_t> slotOf;   // slot of every value
+    uint32_t freeHead = NONE;
+
+public:
+    Handle insert(T value) {
+        uint32_t index;
+        if (freeHead != NONE) {
+            index = freeHead;
+            freeHead = slots[index].dense;
+        } else {
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back({0, 0});
+        }
+        slots[index].dense = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        slotOf.push_back(index);
+        return {index, slots[index].generation};
+    }
+
+    bool contains(Handle handle) const {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    T* find(Handle handle) {
+        return contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+    }
+
+    const T* find(Handle handle) const {
+        return contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+    }
+
+    bool erase(Handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        Slot& slot = slots[handle.index];
+        uint32_t last = static_cast<uint32_t>(values.size()) - 1;
+        if (slot.dense != last) {
+            values[slot.dense] = std::move(values[last]);
+            slotOf[slot.dense] = slotOf[last];
+            slots[slotOf[last]].dense = slot.dense;
+        }
+        values.pop_back();
+        slotOf.pop_back();
+
+        slot.generation++;
+        slot.dense = freeHead;
+        freeHead = handle.index;
+        return true;
+    }
+
+    size_t size() const {
+        return values.size();
+    }
+
+    bool empty() const {
+        return values.empty();
+    }
+
+    T* begin() {
+        return values.data();
+    }
+
+    T* end() {
+        return values.data() + values.size();
+    }
+
+    const T* begin() const {
+        return values.data();
+    }
+
+    const T* end() const {
+        return values.data() + values.size();
+    }
+};
+
+#endif // _SLOTMAP_H_
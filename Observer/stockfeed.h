@@ -0,0 +1,349 @@
+#ifndef _STOCKFEED_H_
+#define _STOCKFEED_H_
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stockmanager.h"
+
+// Read-only mapping of a whole file
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "MappedFile: cannot open " + path);
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "MappedFile: cannot stat " + path);
+        }
+        size = static_cast<size_t>(status.st_size);
+        if (size > 0) {
+            void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            close(fd);
+            if (memory == MAP_FAILED) {
+                throw std::system_error(error, std::generic_category(), "MappedFile: cannot map " + path);
+            }
+            madvise(memory, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(memory);
+        } else {
+            close(fd);
+        }
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+// Applies a batch of stock changes from a memory-mapped feed.
+//
+// The feed is split into one chunk per thread. Every thread parses its
+// chunk in place, resolves names through a private cache of string_views
+// into the mapping, and keeps only the latest change of every product,
+// ordered by its position in the feed. After all threads are through,
+// each product is set to its final state exactly once, so a product that
+// flips several times within a batch notifies at most once and one that
+// ends where it started does not notify at all.
+//
+// Feeds are either CSV lines "product name,1" / "product name,0" (the
+// last comma separates the state, '\r' is ignored), or fixed-width
+// BinaryRecords holding product ids. Binary records naming a product that
+// was not registered before the batch started are malformed.
+//
+// If parsing throws in any thread, nothing of the batch is applied and the
+// first exception is rethrown once all threads have stopped.
+class StockFeed {
+public:
+    enum class Format { Csv, Binary };
+
+    struct BinaryRecord {
+        uint32_t product;
+        uint32_t inStock;       // 0 or 1
+    };
+
+    struct Stats {
+        uint64_t records = 0;
+        uint64_t malformed = 0;
+        uint64_t products = 0;      // distinct products in the batch
+        uint64_t restocked = 0;     // products that notified
+        uint64_t bytes = 0;
+        double seconds = 0.0;
+
+        double recordsPerSecond() const {
+            return seconds > 0.0 ? records / seconds : 0.0;
+        }
+    };
+
+private:
+    // latest change of every product: (offset + 1) << 1 | inStock, 0 if none
+    class LatestTable {
+    private:
+        static constexpr uint32_t CHUNK_SIZE = 65536;
+        static constexpr uint32_t CHUNKS = (uint64_t(1) << 32) / CHUNK_SIZE;
+
+        using Chunk = std::atomic<uint64_t>[CHUNK_SIZE];
+
+        std::unique_ptr<std::atomic<Chunk*>[]> chunks{new std::atomic<Chunk*>[CHUNKS]()};
+
+    public:
+        ~LatestTable() {
+            for (uint32_t c = 0; c < CHUNKS; c++) {
+                delete[] chunks[c].load(std::memory_order_relaxed);
+            }
+        }
+
+        // true for the first change of product
+        bool record(uint32_t product, uint64_t key) {
+            std::atomic<Chunk*>& slot = chunks[product / CHUNK_SIZE];
+            Chunk* chunk = slot.load(std::memory_order_acquire);
+            if (chunk == nullptr) {
+                Chunk* fresh = new Chunk[1]();
+                if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+                    chunk = fresh;
+                } else {
+                    delete[] fresh;
+                }
+            }
+            std::atomic<uint64_t>& latest = (*chunk)[product % CHUNK_SIZE];
+            uint64_t seen = latest.load(std::memory_order_relaxed);
+            while (seen < key && !latest.compare_exchange_weak(seen, key, std::memory_order_relaxed)) {
+            }
+            return seen == 0;
+        }
+
+        uint64_t get(uint32_t product) const {
+            return (*chunks[product / CHUNK_SIZE].load(std::memory_order_acquire))[product % CHUNK_SIZE]
+                .load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Worker {
+        Stats stats;
+        std::vector<uint32_t> touched;      // products whose first change this worker saw
+        std::unordered_map<std::string_view, uint32_t> names;
+        std::exception_ptr error;
+    };
+
+    static constexpr size_t MIN_CHUNK_BYTES = 64 * 1024;
+
+    StockManager& stockManager;
+    unsigned threads;
+
+    static uint64_t keyOf(size_t offset, bool inStock) {
+        return (static_cast<uint64_t>(offset) + 1) << 1 | (inStock ? 1 : 0);
+    }
+
+    void parseCsv(const char* data, size_t begin, size_t end, LatestTable& latest, Worker& worker) {
+        size_t position = begin;
+        while (position < end) {
+            const char* line = data + position;
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - position));
+            size_t length = newline != nullptr ? static_cast<size_t>(newline - line) : end - position;
+            size_t offset = position;
+            position += length + 1;
+
+            if (length > 0 && line[length - 1] == '\r') {
+                length--;
+            }
+            if (length == 0) {
+                continue;
+            }
+            size_t comma = length;
+            while (comma > 0 && line[comma - 1] != ',') {
+                comma--;
+            }
+            std::string_view name(line, comma > 0 ? comma - 1 : 0);
+            std::string_view state(line + comma, length - comma);
+            if (comma == 0 || name.empty() || state.size() != 1 || (state[0] != '0' && state[0] != '1')) {
+                worker.stats.malformed++;
+                continue;
+            }
+
+            auto cached = worker.names.find(name);
+            uint32_t product;
+            if (cached != worker.names.end()) {
+                product = cached->second;
+            } else {
+                product = stockManager.getProductId(name);
+                worker.names.emplace(name, product);
+            }
+            worker.stats.records++;
+            if (latest.record(product, keyOf(offset, state[0] == '1'))) {
+                worker.touched.push_back(product);
+            }
+        }
+    }
+
+    void parseBinary(const char* data, size_t begin, size_t end, size_t products, LatestTable& latest,
+                     Worker& worker) {
+        for (size_t offset = begin; offset < end; offset += sizeof(BinaryRecord)) {
+            BinaryRecord record;
+            std::memcpy(&record, data + offset, sizeof(record));
+            if (record.inStock > 1 || record.product >= products) {
+                worker.stats.malformed++;
+                continue;
+            }
+            worker.stats.records++;
+            if (latest.record(record.product, keyOf(offset, record.inStock == 1))) {
+                worker.touched.push_back(record.product);
+            }
+        }
+    }
+
+    // chunk boundaries: CSV chunks start after a newline, binary chunks on
+    // a record
+    std::vector<size_t> split(const char* data, size_t size, Format format) const {
+        size_t count = std::max<size_t>(1, std::min<size_t>(threads, size / MIN_CHUNK_BYTES));
+        std::vector<size_t> bounds{0};
+        for (size_t c = 1; c < count; c++) {
+            size_t bound = std::max(bounds.back(), size * c / count);
+            if (format == Format::Binary) {
+                bound -= bound % sizeof(BinaryRecord);
+            } else {
+                while (bound < size && data[bound - 1] != '\n') {
+                    bound++;
+                }
+            }
+            bounds.push_back(bound);
+        }
+        bounds.push_back(format == Format::Binary ? size - size % sizeof(BinaryRecord) : size);
+        return bounds;
+    }
+
+public:
+    explicit StockFeed(StockManager& stockManager, unsigned threads = std::thread::hardware_concurrency())
+        : stockManager(stockManager), threads(threads > 0 ? threads : 1) {}
+
+    Stats ingest(const std::string& path, Format format) {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(path);
+        Stats stats = ingest(file.getData(), file.getSize(), format);
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    // data must stay valid until this returns
+    Stats ingest(const char* data, size_t size, Format format) {
+        auto start = std::chrono::steady_clock::now();
+        Stats stats;
+        stats.bytes = size;
+        if (size == 0) {
+            return stats;
+        }
+
+        std::vector<size_t> bounds = split(data, size, format);
+        size_t count = bounds.size() - 1;
+        size_t products = stockManager.getProductCount();
+        LatestTable latest;
+        std::vector<Worker> workers(count);
+        std::barrier parsed(static_cast<std::ptrdiff_t>(count));
+        std::atomic<bool> failed{false};
+
+        // every thread reaches the barrier, even when parsing threw
+        auto work = [&](size_t w) {
+            Worker& worker = workers[w];
+            try {
+                if (format == Format::Csv) {
+                    parseCsv(data, bounds[w], bounds[w + 1], latest, worker);
+                } else {
+                    parseBinary(data, bounds[w], bounds[w + 1], products, latest, worker);
+                }
+            } catch (...) {
+                worker.error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+            parsed.arrive_and_wait();
+            if (failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            // every product is in exactly one worker's list
+            try {
+                for (uint32_t product : worker.touched) {
+                    if (stockManager.setStockStatus((latest.get(product) & 1) != 0, product)) {
+                        worker.stats.restocked++;
+                    }
+                }
+            } catch (...) {
+                worker.error = std::current_exception();
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < count; w++) {
+            try {
+                pool.emplace_back(work, w);
+            } catch (...) {
+                // the chunks left are not parsed, so the batch is dropped
+                workers[w].error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+                for (size_t unstarted = w; unstarted < count; unstarted++) {
+                    parsed.arrive_and_drop();
+                }
+                break;
+            }
+        }
+        work(0);
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        for (const Worker& worker : workers) {
+            if (worker.error) {
+                std::rethrow_exception(worker.error);
+            }
+        }
+        for (const Worker& worker : workers) {
+            stats.records += worker.stats.records;
+            stats.malformed += worker.stats.malformed;
+            stats.restocked += worker.stats.restocked;
+            stats.products += worker.touched.size();
+        }
+        if (format == Format::Binary && size % sizeof(BinaryRecord) != 0) {
+            stats.malformed++;      // truncated last record
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+};
+
+#endif // _STOCKFEED_H_
@@ -0,0 +1,483 @@
+#ifndef _STOCKMANAGER_H_
+#define _STOCKMANAGER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "asyncdispatcher.h"
+#include "compactlist.h"
+#include "debouncer.h"
+#include "epoch.h"
+#include "eventlog.h"
+#include "observer.h"
+#include "observerregistry.h"
+#include "stocktable.h"
+#include "waittable.h"
+
+// Concrete Subject class.
+//
+// Products get a dense id when they are first seen. Subscribers are kept
+// in an inverted index from product id to observer list, so a stock change
+// only touches the observers of that product instead of every registered
+// customer. Every subscription has a handle that cancels it in O(1), and
+// each observer's handles are indexed as well, so removing an observer
+// only visits its own subscriptions.
+//
+// The observer lists live in an ObserverRegistry: notifying takes no lock
+// at all and walks a contiguous array. The registry mutex just serializes
+// writers and guards the name index.
+//
+// Stock state lives in a sharded StockTable outside the registry lock, so
+// ingest threads update it concurrently, and only an out-of-stock to
+// in-stock edge notifies. Threads that only care about one product can
+// block in waitForStock() instead of polling; they sleep on a futex and
+// wake as soon as the product changes.
+//
+// With debouncing started, a restock is announced at once and opens a
+// window; further restocks of the product within it are merged and
+// announced once when it ends, if the product is still in stock then.
+//
+// With an event log open, every stock change is also appended to a
+// memory-mapped log on disk, so an observer that subscribes later can
+// catch up by replaying it from a sequence number or from the latest
+// state of every product. A change and its record are made under one lock
+// per StockTable shard, so the records of a product come in the order of
+// its changes and its latest record is its current state.
+//
+// With a dispatcher started, stock changes are published to it and the
+// observers are called on its threads. Observers may subscribe and
+// unsubscribe from update(); a running notification may or may not see
+// such changes.
+//
+// The dispatcher, the debouncer and the event log may be started and
+// stopped while other threads change stock. They are published through
+// atomic pointers read under an epoch guard, and a replaced one is only
+// destroyed once no thread can still be using it. That wait makes it an
+// error to start or stop them from update().
+class StockManager : public Subject {
+public:
+    using ProductId = uint32_t;
+    using SubscriptionHandle = ObserverRegistry::Handle;
+
+private:
+    // lets names be looked up as string_views without building a string
+    struct NameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>()(name);
+        }
+    };
+
+    std::unordered_map<std::string, ProductId, NameHash, std::equal_to<>> productIds;
+    ObserverRegistry registry;
+
+    // subscriptions of each observer, for removing it; most have one or two
+    std::unordered_map<Observer*, CompactList<SubscriptionHandle, 2>> subscriptions;
+
+    // guards the maps above and serializes registry writers; notifying
+    // never takes it
+    mutable std::shared_mutex registryMutex;
+
+    StockTable stockTable;
+    WaitTable waitTable;
+
+    // held across a change and its log record while a log is open
+    struct alignas(64) LogLock {
+        std::mutex mutex;
+    };
+
+    std::unique_ptr<LogLock[]> logLocks{new LogLock[StockTable::SHARDS]};
+    // owned; read under an EpochDomain::Guard, replaced by replace()
+    std::atomic<AsyncDispatcher*> dispatcher{nullptr};
+    std::atomic<Debouncer*> debouncer{nullptr};
+    std::atomic<EventLog*> eventLog{nullptr};
+
+    // Publishes next in place of the current component and destroys that
+    // once every thread that might have loaded it has left its guard
+    template <typename T>
+    void replace(std::atomic<T*>& slot, std::unique_ptr<T> next) {
+        if (EpochDomain::get().inReader()) {
+            throw std::logic_error("StockManager: cannot start or stop components from update()");
+        }
+        std::unique_ptr<T> previous(slot.exchange(next.release(), std::memory_order_acq_rel));
+        if (previous) {
+            EpochDomain::get().synchronize();
+        }
+    }
+
+    void deliver(ProductId product) {
+        EpochDomain::Guard guard;
+        if (AsyncDispatcher* current = dispatcher.load(std::memory_order_acquire)) {
+            current->publish(product, true);
+        } else {
+            notifyObservers(product);
+        }
+    }
+
+    ProductId addProduct(std::string_view productName) {
+        auto it = productIds.find(productName);
+        if (it != productIds.end()) {
+            return it->second;
+        }
+        std::string name(productName);
+        ProductId product = registry.addProduct(name);
+        productIds.emplace(std::move(name), product);
+        return product;
+    }
+
+    // The handle of observer's subscription to product, if any; scans
+    // whichever of the two lists is shorter
+    SubscriptionHandle findSubscription(Observer* observer, ProductId product) const {
+        auto handles = subscriptions.find(observer);
+        if (handles == subscriptions.end()) {
+            return SubscriptionHandle();
+        }
+        if (registry.getSubscriberCount(product) < handles->second.size()) {
+            return registry.find(observer, product);
+        }
+        for (SubscriptionHandle handle : handles->second) {
+            if (registry.find(handle)->product == product) {
+                return handle;
+            }
+        }
+        return SubscriptionHandle();
+    }
+
+    SubscriptionHandle addSubscription(Observer* observer, ProductId product) {
+        SubscriptionHandle handle = findSubscription(observer, product);
+        if (registry.find(handle) == nullptr) {
+            handle = registry.subscribe(observer, product);
+            if (registry.find(handle) != nullptr) {
+                subscriptions[observer].push_back(handle);
+            }
+        }
+        return handle;
+    }
+
+    bool removeSubscription(SubscriptionHandle handle) {
+        const ObserverRegistry::Subscription* subscription = registry.find(handle);
+        if (subscription == nullptr) {
+            return false;
+        }
+        auto handles = subscriptions.find(subscription->observer);
+        registry.unsubscribe(handle);
+        handles->second.erase(handle);
+        if (handles->second.empty()) {
+            subscriptions.erase(handles);
+        }
+        return true;
+    }
+
+    // Names of the products observer subscribes to; empty with wildcard
+    // set if it subscribes to everything
+    std::unordered_set<std::string_view> subscribedNames(Observer* observer, bool& wildcard) const {
+        std::unordered_set<std::string_view> names;
+        wildcard = false;
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        auto handles = subscriptions.find(observer);
+        if (handles == subscriptions.end()) {
+            return names;
+        }
+        for (SubscriptionHandle handle : handles->second) {
+            ProductId product = registry.find(handle)->product;
+            if (product == ObserverRegistry::ALL_PRODUCTS) {
+                wildcard = true;
+                names.clear();
+                break;
+            }
+            names.insert(registry.getProductNameView(product));
+        }
+        return names;
+    }
+
+public:
+    ~StockManager() {
+        stopDebouncing();
+        stopDispatcher();
+        closeEventLog();
+    }
+
+    // Returns the id of productName, adding the product if it is new
+    ProductId getProductId(std::string_view productName) {
+        {
+            std::shared_lock<std::shared_mutex> lock(registryMutex);
+            auto it = productIds.find(productName);
+            if (it != productIds.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        return addProduct(productName);
+    }
+
+    std::string getProductName(ProductId product) const {
+        return registry.getProductName(product);
+    }
+
+    size_t getProductCount() const {
+        return registry.getProductCount();
+    }
+
+    size_t getSubscriberCount(const std::string& productName) const {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        auto it = productIds.find(productName);
+        return it != productIds.end() ? registry.getSubscriberCount(it->second) : 0;
+    }
+
+    void registerObserver(Observer* observer) override {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        addSubscription(observer, ObserverRegistry::ALL_PRODUCTS);
+    }
+
+    // Once this returns no notification is using observer any more, so it
+    // may be deleted; called from update() it cannot wait for the running
+    // notification, which may still reach observer
+    void removeObserver(Observer* observer) override {
+        {
+            std::unique_lock<std::shared_mutex> lock(registryMutex);
+            auto handles = subscriptions.find(observer);
+            if (handles != subscriptions.end()) {
+                for (SubscriptionHandle handle : handles->second) {
+                    registry.unsubscribe(handle);
+                }
+                subscriptions.erase(handles);
+            }
+        }
+        if (!EpochDomain::get().inReader()) {
+            EpochDomain::get().synchronize();
+        }
+    }
+
+    void subscribe(Observer* observer, const std::string& productName) override {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        addSubscription(observer, addProduct(productName));
+    }
+
+    // Returns the handle of the new or existing subscription, or an
+    // invalid handle if product was never added
+    SubscriptionHandle subscribe(Observer* observer, ProductId product) {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        return addSubscription(observer, product);
+    }
+
+    void unsubscribe(Observer* observer, const std::string& productName) override {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        auto it = productIds.find(productName);
+        if (it != productIds.end()) {
+            removeSubscription(findSubscription(observer, it->second));
+        }
+    }
+
+    void unsubscribe(Observer* observer, ProductId product) {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        removeSubscription(findSubscription(observer, product));
+    }
+
+    // O(1) in the number of subscribers; false if the handle is stale
+    bool unsubscribe(SubscriptionHandle handle) {
+        std::unique_lock<std::shared_mutex> lock(registryMutex);
+        return removeSubscription(handle);
+    }
+
+    bool isSubscribed(SubscriptionHandle handle) const {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        return registry.find(handle) != nullptr;
+    }
+
+    void notifyObservers(const std::string& productName) override {
+        notifyObservers(getProductId(productName));
+    }
+
+    // Lock-free; ids that were never added have nobody to notify
+    void notifyObservers(ProductId product) {
+        registry.forEachObserver(product, [](const std::string& productName, Observer* observer) {
+            observer->update(productName); // Notify with product name
+        });
+    }
+
+    bool setStockStatus(bool inStock, const std::string& productName) {
+        return setStockStatus(inStock, getProductId(productName));
+    }
+
+    // Safe to call from many threads; notifies only when the product
+    // comes back in stock, and returns whether it did. A restock that is
+    // held back by the debouncer returns false. Changes of ids that were
+    // never added are ignored.
+    bool setStockStatus(bool inStock, ProductId product) {
+        if (product >= registry.getProductCount()) {
+            return false;
+        }
+        // a product already in that state needs neither the guard nor a lock
+        if (stockTable.isInStock(product) == inStock) {
+            return false;
+        }
+        EpochDomain::Guard guard;
+        if (EventLog* log = eventLog.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(logLocks[product % StockTable::SHARDS].mutex);
+            if (!stockTable.change(product, inStock)) {
+                return false;
+            }
+            log->append(product, registry.getProductNameView(product), inStock);
+        } else if (!stockTable.change(product, inStock)) {
+            return false;
+        }
+        waitTable.notify(product);
+        if (!inStock) {
+            return false;
+        }
+        if (Debouncer* current = debouncer.load(std::memory_order_acquire)) {
+            return current->submit(product);
+        }
+        deliver(product);
+        return true;
+    }
+
+    bool isInStock(ProductId product) const {
+        return stockTable.isInStock(product);
+    }
+
+    // Blocks until product is in the wanted state or timeout passes, and
+    // returns whether it got there
+    bool waitForStock(ProductId product, bool inStock = true,
+                      std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) {
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = timeout >= std::chrono::steady_clock::time_point::max() - now
+            ? std::chrono::steady_clock::time_point::max()
+            : now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+        return waitTable.wait(product, [&] { return stockTable.isInStock(product) == inStock; }, deadline);
+    }
+
+    const StockTable& getStockTable() const {
+        return stockTable;
+    }
+
+    // From now on observers are called on the dispatcher's threads
+    void startDispatcher(const AsyncDispatcher::Options& options) {
+        replace(dispatcher, std::make_unique<AsyncDispatcher>(
+            [this](uint32_t product, bool) { notifyObservers(product); }, options));
+    }
+
+    // Delivers what is still queued and goes back to synchronous updates
+    void stopDispatcher() {
+        replace(dispatcher, std::unique_ptr<AsyncDispatcher>());
+    }
+
+    // From now on restocks are debounced; without a dispatcher, restocks
+    // held back until the end of a window are delivered on the
+    // debouncer's timer thread
+    void startDebouncing(const Debouncer::Options& options) {
+        replace(debouncer, std::make_unique<Debouncer>(
+            [this](uint32_t product) {
+                if (!stockTable.isInStock(product)) {
+                    return false;   // sold out again within the window
+                }
+                deliver(product);
+                return true;
+            },
+            options));
+    }
+
+    // Delivers what is still pending and notifies immediately again
+    void stopDebouncing() {
+        replace(debouncer, std::unique_ptr<Debouncer>());
+    }
+
+    Debouncer::Metrics getDebounceMetrics() const {
+        EpochDomain::Guard guard;
+        const Debouncer* current = debouncer.load(std::memory_order_acquire);
+        return current != nullptr ? current->getMetrics() : Debouncer::Metrics();
+    }
+
+    // Waits until every stock change so far has reached its observers,
+    // ending open debounce windows early
+    void flushNotifications() {
+        EpochDomain::Guard guard;
+        if (Debouncer* current = debouncer.load(std::memory_order_acquire)) {
+            current->flush();
+        }
+        if (AsyncDispatcher* current = dispatcher.load(std::memory_order_acquire)) {
+            current->drain();
+        }
+    }
+
+    AsyncDispatcher::Metrics getDispatcherMetrics() const {
+        EpochDomain::Guard guard;
+        const AsyncDispatcher* current = dispatcher.load(std::memory_order_acquire);
+        return current != nullptr ? current->getMetrics() : AsyncDispatcher::Metrics();
+    }
+
+    // From now on every stock change is appended to the log in
+    // options.directory, which is created or recovered
+    void openEventLog(const EventLog::Options& options) {
+        replace(eventLog, std::make_unique<EventLog>(options));
+        // changes made without the log, and so without its lock, are over
+        // once no thread is left in a guard that saw no log
+        EpochDomain::get().synchronize();
+    }
+
+    // Flushes the log to disk and stops logging
+    void closeEventLog() {
+        replace(eventLog, std::unique_ptr<EventLog>());
+    }
+
+    // null unless a log is open; valid until the log is closed or
+    // replaced
+    const EventLog* getEventLog() const {
+        return eventLog.load(std::memory_order_acquire);
+    }
+
+    // Calls observer->update() on the calling thread for every logged
+    // restock from fromSequence on of a product it subscribes to, and
+    // returns the sequence to continue from
+    uint64_t replay(Observer* observer, uint64_t fromSequence = 1) {
+        EpochDomain::Guard guard;
+        const EventLog* log = eventLog.load(std::memory_order_acquire);
+        if (log == nullptr) {
+            return fromSequence;
+        }
+        bool wildcard;
+        std::unordered_set<std::string_view> names = subscribedNames(observer, wildcard);
+        std::string productName;
+        return log->replay(fromSequence, [&](const EventLog::Event& event) {
+            if (event.inStock && (wildcard || names.count(event.productName) != 0)) {
+                productName.assign(event.productName);
+                observer->update(productName);
+            }
+        });
+    }
+
+    // Like replay(), but only announces the products of observer whose
+    // latest logged change was a restock; returns how many it announced
+    size_t replayLatest(Observer* observer) {
+        EpochDomain::Guard guard;
+        const EventLog* log = eventLog.load(std::memory_order_acquire);
+        if (log == nullptr) {
+            return 0;
+        }
+        bool wildcard;
+        std::unordered_set<std::string_view> names = subscribedNames(observer, wildcard);
+        std::string productName;
+        size_t announced = 0;
+        log->replayLatest([&](const EventLog::Event& event) {
+            if (event.inStock && (wildcard || names.count(event.productName) != 0)) {
+                productName.assign(event.productName);
+                observer->update(productName);
+                announced++;
+            }
+        });
+        return announced;
+    }
+};
+
+#endif // _STOCKMANAGER_H_
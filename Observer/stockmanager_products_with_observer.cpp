@@ -1,82 +1,10 @@
+#include <chrono>
 #include <iostream>
-#include <vector>
 #include <string>
-#include <unordered_set>
+#include <thread>
 
-// Forward declaration of Observer interface
-class Observer;
-
-// Subject interface
-class Subject {
-public:
-    virtual ~Subject() {}
-    virtual void registerObserver(Observer* observer) = 0;
-    virtual void removeObserver(Observer* observer) = 0;
-    virtual void notifyObservers(const std::string& productName) = 0;
-};
-
-// Observer interface
-class Observer {
-public:
-    virtual ~Observer() {}
-    virtual void update(const std::string& productName) = 0;
-};
-
-// Concrete Subject class
-class StockManager : public Subject {
-private:
-    std::vector<Observer*> observers;
-    bool productInStock;
-
-public:
-    StockManager() : productInStock(false) {}
-
-    void registerObserver(Observer* observer) override {
-        observers.push_back(observer);
-    }
-
-    void removeObserver(Observer* observer) override {
-        auto it = std::find(observers.begin(), observers.end(), observer);
-        if (it != observers.end()) {
-            observers.erase(it);
-        }
-    }
-
-    void notifyObservers(const std::string& productName) override {
-        for (Observer* observer : observers) {
-            observer->update(productName); // Notify with product name
-        }
-    }
-
-    void setStockStatus(bool inStock, const std::string& productName) {
-        if (productInStock != inStock) {
-            productInStock = inStock;
-            notifyObservers(productName);
-        }
-    }
-};
-
-// Concrete Observer class
-class Customer : public Observer {
-private:
-    std::string name;
-    std::unordered_set<std::string> interests; // Products customer is interested in
-
-public:
-    Customer(const std::string& name) : name(name) {}
-
-    // Add interest in a product
-    void addInterest(const std::string& productName) {
-        interests.insert(productName);
-    }
-
-    // Update method checks if the notification is for an interested product
-    void update(const std::string& productName) override {
-        if (interests.find(productName) != interests.end()) {
-            std::cout << "Notification for " << name << ": " << productName << " is back in stock!" << std::endl;
-        }
-    }
-};
+#include "customer.h"
+#include "stockmanager.h"
 
 int main() {
     // Create subject
@@ -86,17 +14,49 @@ int main() {
     Customer customer1("Customer 1");
     Customer customer2("Customer 2");
 
-    // Register observers
-    stockManager.registerObserver(&customer1);
-    stockManager.registerObserver(&customer2);
-
-    // Set interests for customers
-    customer1.addInterest("Product A");
-    customer2.addInterest("Product B");
+    // Subscribe customers to the products they are interested in
+    stockManager.subscribe(&customer1, "Product A");
+    stockManager.subscribe(&customer2, "Product B");
 
     // Notify observers when product is back in stock
     stockManager.setStockStatus(true, "Product A");
     stockManager.setStockStatus(true, "Product B");
 
+    // Customers that leave are no longer notified
+    stockManager.removeObserver(&customer1);
+    stockManager.setStockStatus(false, "Product A");
+    stockManager.setStockStatus(true, "Product A");
+
+    // Deliver on two dispatcher threads, so a slow customer no longer
+    // holds up the stock updates; queued changes of a product coalesce
+    AsyncDispatcher::Options options;
+    options.threads = 2;
+    options.backpressure = AsyncDispatcher::Backpressure::Coalesce;
+    stockManager.startDispatcher(options);
+    stockManager.setStockStatus(false, "Product B");
+    stockManager.setStockStatus(true, "Product B");
+    stockManager.flushNotifications();
+
+    AsyncDispatcher::Metrics metrics = stockManager.getDispatcherMetrics();
+    std::cout << "Published " << metrics.published << ", delivered " << metrics.delivered
+              << ", coalesced " << metrics.coalesced << ", max queue depth " << metrics.maxQueueDepth
+              << ", p99 latency " << metrics.p99LatencyNs << " ns" << std::endl;
+    stockManager.stopDispatcher();
+
+    // A flapping product is announced once per 50 ms window at most
+    Debouncer::Options debounce;
+    debounce.window = std::chrono::milliseconds(50);
+    stockManager.startDebouncing(debounce);
+    for (int flip = 0; flip < 5; flip++) {
+        stockManager.setStockStatus(false, "Product B");
+        stockManager.setStockStatus(true, "Product B");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    Debouncer::Metrics debounced = stockManager.getDebounceMetrics();
+    std::cout << "Restocks " << debounced.submitted << ", delivered " << debounced.delivered
+              << ", suppressed " << debounced.suppressed << std::endl;
+    stockManager.stopDebouncing();
+
     return 0;
 }
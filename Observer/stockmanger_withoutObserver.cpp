@@ -1,21 +1,32 @@
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 #include <thread>
 
 class StockManager {
 private:
-    bool productInStock;
+    // Number of status changes so far. The product starts out of stock
+    // and every change flips it, so the lowest bit is the status; waiting
+    // on the count instead of the bool cannot miss a change that is
+    // undone before the waiter looks again.
+    std::atomic<uint32_t> changes;
 
 public:
-    StockManager() : productInStock(false) {}
+    StockManager() : changes(0) {}
 
     void setStockStatus(bool inStock) {
-        if (productInStock != inStock) {
-            productInStock = inStock;
-            if (inStock)
-                notifyCustomers();
+        uint32_t seen = changes.load();
+        while ((seen & 1) != static_cast<uint32_t>(inStock)) {
+            if (changes.compare_exchange_weak(seen, seen + 1)) {
+                // wake the threads blocked in waitForChange()
+                changes.notify_all();
+                if (inStock)
+                    notifyCustomers();
+                return;
+            }
         }
     }
 
@@ -24,7 +35,25 @@ public:
     }
 
     bool isInStock() const {
-        return productInStock;
+        return (changes & 1) != 0;
+    }
+
+    uint32_t getChangeCount() const {
+        return changes;
+    }
+
+    // Blocks (on a futex on Linux) until there were changes after the
+    // first seen ones, instead of checking again and again, and returns
+    // the new count
+    uint32_t waitForChange(uint32_t seen) const {
+        changes.wait(seen);
+        return changes;
+    }
+
+    // Restocks among the changes after the first from, up to the first to.
+    // Restocks are the odd-numbered changes.
+    static uint32_t restocksBetween(uint32_t from, uint32_t to) {
+        return (to - from + (~from & 1)) / 2;
     }
 };
 
@@ -46,19 +75,31 @@ int main() {
     Customer customer1("Customer 1");
     Customer customer2("Customer 2");
 
-    bool previousStockStatus = false;
-
-    while (true) {
-        bool currentStockStatus = stockManager.isInStock();
-        if (currentStockStatus && !previousStockStatus) {
-            customer1.notify("Product A is back in stock!");
-            customer2.notify("Product A is back in stock!");
+    // The watcher still has to know about every customer, but it no longer
+    // polls: it sleeps until the stock status changes and reacts at once
+    std::thread watcher([&] {
+        uint32_t seenChanges = stockManager.getChangeCount();
+        for (uint32_t restocks = 0; restocks < 2;) {
+            uint32_t changes = stockManager.waitForChange(seenChanges);
+            // a restock that was sold out again before we woke up
+            // still counts and is still announced
+            for (uint32_t n = StockManager::restocksBetween(seenChanges, changes); n > 0; n--) {
+                customer1.notify("Product A is back in stock!");
+                customer2.notify("Product A is back in stock!");
+                restocks++;
+            }
+            seenChanges = changes;
         }
-        previousStockStatus = currentStockStatus;
+    });
 
-        // Wait for a while before checking again (simulate real-time scenario)
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-    }
+    // Simulate deliveries and sales
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stockManager.setStockStatus(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stockManager.setStockStatus(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stockManager.setStockStatus(true);
 
+    watcher.join();
     return 0;
 }
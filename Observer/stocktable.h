@@ -0,0 +1,142 @@
+#ifndef _STOCKTABLE_H_
+#define _STOCKTABLE_H_
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+// Stock state of every SKU, updated concurrently without a global lock.
+//
+// Product ids are spread round-robin over the shards, so ingest threads
+// working on neighbouring ids write to different shards instead of
+// sharing cache lines. Every shard sits on its own cache lines and keeps
+// its states in fixed-size chunks that are allocated on first use and
+// never move, so a lookup is three loads and an update is one atomic
+// exchange that also tells whether the state really changed. The chunk
+// directory is allocated lazily in segments that double in size, so an
+// empty table costs a few hundred bytes per shard and memory grows with
+// the highest product id rather than the whole id space.
+class StockTable {
+public:
+    static constexpr uint32_t SHARDS = 64;
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr uint32_t CHUNK_SIZE = 4096;
+    // directory segment k holds the 2^k chunks from 2^k - 1 on; 15
+    // segments cover every 32-bit product id
+    static constexpr int SEGMENTS = 15;
+
+    using Chunk = std::atomic<uint8_t>[CHUNK_SIZE];
+    using Slot = std::atomic<Chunk*>;
+
+    struct alignas(CACHE_LINE) Shard {
+        std::atomic<Slot*> segments[SEGMENTS] = {};
+        std::atomic<uint64_t> inStock{0};
+        std::atomic<uint64_t> restocks{0};
+
+        ~Shard() {
+            for (int k = 0; k < SEGMENTS; k++) {
+                Slot* segment = segments[k].load(std::memory_order_relaxed);
+                if (segment == nullptr) {
+                    continue;
+                }
+                for (uint32_t c = 0; c < (uint32_t(1) << k); c++) {
+                    delete[] segment[c].load(std::memory_order_relaxed);
+                }
+                delete[] segment;
+            }
+        }
+    };
+
+    std::unique_ptr<Shard[]> shards{new Shard[SHARDS]};
+
+    // racing threads may both allocate; the loser frees its copy
+    template <typename T>
+    static T* install(std::atomic<T*>& slot, T* fresh) {
+        T* current = nullptr;
+        if (slot.compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) {
+            return fresh;
+        }
+        delete[] fresh;
+        return current;
+    }
+
+    std::atomic<uint8_t>* find(uint32_t product) const {
+        const Shard& shard = shards[product % SHARDS];
+        uint32_t index = product / SHARDS;
+        uint32_t c = index / CHUNK_SIZE + 1;
+        int k = std::bit_width(c) - 1;
+        const Slot* segment = shard.segments[k].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            return nullptr;
+        }
+        Chunk* chunk = segment[c - (uint32_t(1) << k)].load(std::memory_order_acquire);
+        return chunk != nullptr ? &(*chunk)[index % CHUNK_SIZE] : nullptr;
+    }
+
+    std::atomic<uint8_t>& state(uint32_t product) {
+        Shard& shard = shards[product % SHARDS];
+        uint32_t index = product / SHARDS;
+        uint32_t c = index / CHUNK_SIZE + 1;
+        int k = std::bit_width(c) - 1;
+        Slot* segment = shard.segments[k].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            segment = install(shard.segments[k], new Slot[uint32_t(1) << k]());
+        }
+        Slot& slot = segment[c - (uint32_t(1) << k)];
+        Chunk* chunk = slot.load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            chunk = install(slot, new Chunk[1]());
+        }
+        return (*chunk)[index % CHUNK_SIZE];
+    }
+
+public:
+    // Sets the state of product and returns true only for an
+    // out-of-stock to in-stock edge
+    bool set(uint32_t product, bool inStock) {
+        return change(product, inStock) && inStock;
+    }
+
+    // Sets the state of product and returns true if it was different
+    bool change(uint32_t product, bool inStock) {
+        uint8_t previous = state(product).exchange(inStock ? 1 : 0, std::memory_order_acq_rel);
+        if (previous == static_cast<uint8_t>(inStock)) {
+            return false;
+        }
+        Shard& shard = shards[product % SHARDS];
+        if (inStock) {
+            shard.inStock.fetch_add(1, std::memory_order_relaxed);
+            shard.restocks.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            shard.inStock.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool isInStock(uint32_t product) const {
+        const std::atomic<uint8_t>* s = find(product);
+        return s != nullptr && s->load(std::memory_order_acquire) != 0;
+    }
+
+    uint64_t getInStockCount() const {
+        uint64_t count = 0;
+        for (uint32_t s = 0; s < SHARDS; s++) {
+            count += shards[s].inStock.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    // out-of-stock to in-stock edges seen so far
+    uint64_t getRestockCount() const {
+        uint64_t count = 0;
+        for (uint32_t s = 0; s < SHARDS; s++) {
+            count += shards[s].restocks.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+};
+
+#endif // _STOCKTABLE_H_
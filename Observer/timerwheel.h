@@ -0,0 +1,85 @@
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hashed timer wheel counting time in ticks.
+//
+// A timer due at tick t waits in slot t % slots, so scheduling is a
+// push_back and advancing by one tick only looks at one slot. Timers more
+// than one turn away stay in their slot until their tick comes round.
+// Not thread-safe.
+template <typename T>
+class TimerWheel {
+private:
+    struct Timer {
+        T value;
+        uint64_t deadline;
+    };
+
+    std::vector<std::vector<Timer>> slots;
+    uint64_t current = 0;
+    size_t count = 0;
+
+public:
+    explicit TimerWheel(size_t slotCount) : slots(slotCount > 0 ? slotCount : 1) {}
+
+    uint64_t getCurrentTick() const {
+        return current;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // fires delay ticks from now, but never in the current tick
+    void schedule(const T& value, uint64_t delay) {
+        uint64_t deadline = current + (delay > 0 ? delay : 1);
+        slots[deadline % slots.size()].push_back({value, deadline});
+        count++;
+    }
+
+    // Moves time forward to tick and calls fire(value) for every timer
+    // that came due, in tick order
+    template <typename Fire>
+    void advance(uint64_t tick, Fire fire) {
+        while (current < tick) {
+            if (count == 0) {
+                current = tick;     // nothing to visit on the way
+                return;
+            }
+            current++;
+            std::vector<Timer>& slot = slots[current % slots.size()];
+            size_t kept = 0;
+            for (size_t i = 0; i < slot.size(); i++) {
+                if (slot[i].deadline <= current) {
+                    fire(slot[i].value);
+                    count--;
+                } else {
+                    slot[kept++] = slot[i];
+                }
+            }
+            slot.resize(kept);
+        }
+    }
+
+    // fires every timer now, in no particular order
+    template <typename Fire>
+    void fireAll(Fire fire) {
+        for (std::vector<Timer>& slot : slots) {
+            for (Timer& timer : slot) {
+                fire(timer.value);
+            }
+            slot.clear();
+        }
+        count = 0;
+    }
+};
+
+#endif // _TIMERWHEEL_H_
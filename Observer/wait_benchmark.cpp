@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "latencyhistogram.h"
+#include "stockmanager.h"
+
+// Wake latency and CPU use of watcher threads that wait for a restock,
+// polling isInStock() as stockmanger_withoutObserver did, against blocking
+// in StockManager::waitForStock().
+//
+// usage: wait_benchmark [watchers] [products] [poll interval ms] [idle ms]
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// user plus system time of the whole process
+static double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct Result {
+    double idleCpuPerSecond;    // CPU seconds burnt per second of waiting
+    uint64_t p50LatencyNs;
+    uint64_t p99LatencyNs;
+    uint64_t maxLatencyNs;
+};
+
+template <typename Watch>
+Result run(unsigned watchers, uint32_t products, int idleMilliseconds, Watch watch) {
+    StockManager stockManager;
+    for (uint32_t p = 0; p < products; p++) {
+        stockManager.getProductId("Product " + std::to_string(p));
+    }
+    std::vector<std::atomic<int64_t>> restockedNs(products);
+    LatencyHistogram latency;
+    std::atomic<unsigned> started{0};
+
+    std::vector<std::thread> threads;
+    threads.reserve(watchers);
+    for (unsigned w = 0; w < watchers; w++) {
+        threads.emplace_back([&, w] {
+            uint32_t product = w % products;
+            started.fetch_add(1, std::memory_order_relaxed);
+            watch(stockManager, product);
+            latency.record(static_cast<uint64_t>(nowNs() - restockedNs[product].load(std::memory_order_acquire)));
+        });
+    }
+    while (started.load(std::memory_order_relaxed) < watchers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    double before = cpuSeconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(idleMilliseconds));
+    double idle = cpuSeconds() - before;
+
+    for (uint32_t p = 0; p < products; p++) {
+        restockedNs[p].store(nowNs(), std::memory_order_release);
+        stockManager.setStockStatus(true, p);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    return {idle / (idleMilliseconds / 1000.0), latency.percentile(0.50), latency.percentile(0.99), latency.getMax()};
+}
+
+static void print(const std::string& name, const Result& result) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << result.idleCpuPerSecond
+              << std::setw(14) << result.p50LatencyNs / 1000
+              << std::setw(14) << result.p99LatencyNs / 1000
+              << std::setw(14) << result.maxLatencyNs / 1000 << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    unsigned watchers = argc > 1 ? std::stoul(argv[1]) : 10000;
+    uint32_t products = argc > 2 ? std::stoul(argv[2]) : 1000;
+    int pollMilliseconds = argc > 3 ? std::stoi(argv[3]) : 100;
+    int idleMilliseconds = argc > 4 ? std::stoi(argv[4]) : 1000;
+
+    std::cout << watchers << " watchers on " << products << " products\n\n";
+    std::cout << std::left << std::setw(16) << "model" << std::right << std::setw(12) << "idle cpu/s"
+              << std::setw(14) << "p50 wake us" << std::setw(14) << "p99 wake us" << std::setw(14) << "max wake us"
+              << '\n';
+
+    std::chrono::milliseconds interval(pollMilliseconds);
+    print("poll " + std::to_string(pollMilliseconds) + " ms",
+          run(watchers, products, idleMilliseconds, [interval](StockManager& stockManager, uint32_t product) {
+              while (!stockManager.isInStock(product)) {
+                  std::this_thread::sleep_for(interval);
+              }
+          }));
+    print("waitForStock",
+          run(watchers, products, idleMilliseconds, [](StockManager& stockManager, uint32_t product) {
+              stockManager.waitForStock(product);
+          }));
+    return 0;
+}
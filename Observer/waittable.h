@@ -0,0 +1,109 @@
+#ifndef _WAITTABLE_H_
+#define _WAITTABLE_H_
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+// Lets threads sleep until a product changes state.
+//
+// Products hash onto a fixed table of futex words. A waiter announces
+// itself in its bucket, reads the bucket's sequence, checks its condition
+// and sleeps in the kernel only while the sequence is unchanged; a state
+// change bumps the sequence and wakes the bucket, but only if somebody is
+// waiting there, so writers without waiters never make a system call.
+// Products sharing a bucket cause spurious wakeups, which waiters absorb by
+// checking their condition again.
+class WaitTable {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr uint32_t BUCKETS = 4096;
+
+    struct alignas(CACHE_LINE) Bucket {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint32_t> waiters{0};
+    };
+
+    std::unique_ptr<Bucket[]> buckets{new Bucket[BUCKETS]};
+
+    Bucket& bucketOf(uint32_t product) {
+        // Fibonacci hashing spreads neighbouring ids over the table
+        return buckets[(product * 2654435769u) >> 20];
+    }
+
+    // false once deadline has passed
+    static bool sleep(std::atomic<uint32_t>& word, uint32_t seen,
+                      std::chrono::steady_clock::time_point deadline) {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::steady_clock::duration::zero()) {
+            return false;
+        }
+#ifdef __linux__
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timespec timeout{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, seen, &timeout, nullptr, 0);
+#else
+        // no timed wait on std::atomic; nap until the word moves
+        while (word.load(std::memory_order_acquire) == seen && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+#endif
+        return true;
+    }
+
+    static void wakeAll(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)word;
+#endif
+    }
+
+public:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+
+    // Blocks until ready() returns true or the deadline passes, and returns
+    // the last result of ready(). Must be paired with notify(product) after
+    // every change that can make ready() true.
+    template <typename Ready>
+    bool wait(uint32_t product, Ready ready, std::chrono::steady_clock::time_point deadline) {
+        Bucket& bucket = bucketOf(product);
+        bucket.waiters.fetch_add(1, std::memory_order_relaxed);
+        // pairs with the fence in notify(): either the writer sees this
+        // waiter or this waiter sees the new state
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool result;
+        while (true) {
+            uint32_t seen = bucket.sequence.load(std::memory_order_acquire);
+            result = ready();
+            if (result || !sleep(bucket.sequence, seen, deadline)) {
+                break;
+            }
+        }
+        bucket.waiters.fetch_sub(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    // Called after the state of product changed
+    void notify(uint32_t product) {
+        Bucket& bucket = bucketOf(product);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (bucket.waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        bucket.sequence.fetch_add(1, std::memory_order_release);
+        wakeAll(bucket.sequence);
+    }
+};
+
+#endif // _WAITTABLE_H_
@@ -0,0 +1,60 @@
+#ifndef _BASICCONTEXT_H_
+#define _BASICCONTEXT_H_
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+/***********************************************************************
+ * Compile-time variant of Context. The strategy and the comparator are
+ * template parameters, so the call to performSort() is resolved at
+ * compile time and the comparator can be inlined into the inner loops.
+ *
+ * A Strategy is any type with a member
+ *     template <typename T, typename Compare>
+ *     void performSort(std::vector<T>&, Compare);
+ ***********************************************************************/
+template <typename T, typename Strategy, typename Compare = std::less<T>>
+class BasicContext
+{
+	private:
+		Strategy sortAlgorithm;
+		Compare comparator;
+		std::vector<T> array;
+
+	public:
+		BasicContext() = default;
+
+		explicit BasicContext(Strategy strategy, Compare comp = Compare())
+			: sortAlgorithm(std::move(strategy)), comparator(std::move(comp))
+		{
+		}
+
+		Strategy& getSortAlgorithm()
+		{
+			return sortAlgorithm;
+		}
+
+		void setArray(std::vector<T>& arr)
+		{
+			array = arr;
+		}
+
+		// takes over the caller's vector instead of copying it
+		void setArray(std::vector<T>&& arr)
+		{
+			array = std::move(arr);
+		}
+
+		void sort()
+		{
+			sortAlgorithm.performSort(array, comparator);
+		}
+
+		std::vector<T>& getArray()
+		{
+			return array;
+		}
+};
+
+#endif // _BASICCONTEXT_H_
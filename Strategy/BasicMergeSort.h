@@ -0,0 +1,78 @@
+#ifndef BASICMERGESORT
+#define BASICMERGESORT
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class BasicMergeSort
+{
+	/***********************************************************************
+	 * Compile-time mergesort for BasicContext: same algorithm as
+	 * MergeSort, but for any element type and comparator.
+	 ***********************************************************************/
+public:
+	template <typename T, typename Compare>
+	void performSort(std::vector<T>& a, Compare comp)
+	{
+		// elements are move-constructed into aux as they are merged, so T
+		// needs no default constructor
+		std::vector<T> aux;
+		aux.reserve(a.size());
+		sort(a, aux, 0, a.size(), comp);
+	}
+
+private:
+	/***********************************************************************
+	 * Merge a[lo] .. a[mid-1] and a[mid] .. a[hi-1] into a[lo] .. a[hi-1]
+	 * using aux[] as scratch space. Equal elements keep their order.
+	 ***********************************************************************/
+	template <typename T, typename Compare>
+	static void merge(std::vector<T>& a, std::vector<T>& aux, size_t lo, size_t mid, size_t hi, Compare& comp)
+	{
+		aux.clear();
+		size_t i = lo, j = mid;
+		while (i < mid && j < hi)
+		{
+			if (comp(a[j], a[i]))
+			{
+				aux.push_back(std::move(a[j++]));
+			}
+			else
+			{
+				aux.push_back(std::move(a[i++]));
+			}
+		}
+		while (i < mid)
+		{
+			aux.push_back(std::move(a[i++]));
+		}
+
+		// the rest of the right half is already in place; copy back
+		for (size_t k = 0; k < aux.size(); k++)
+		{
+			a[lo + k] = std::move(aux[k]);
+		}
+	}
+
+	template <typename T, typename Compare>
+	static void sort(std::vector<T>& a, std::vector<T>& aux, size_t lo, size_t hi, Compare& comp)
+	{
+		// base case
+		if (hi - lo <= 1)
+		{
+			return;
+		}
+
+		// sort each half, recursively
+		size_t mid = lo + (hi - lo) / 2;
+		sort(a, aux, lo, mid, comp);
+		sort(a, aux, mid, hi, comp);
+
+		// merge back together
+		merge(a, aux, lo, mid, hi, comp);
+	}
+};
+
+
+#endif	//#ifndef BASICMERGESORT
@@ -0,0 +1,86 @@
+#ifndef BASICQUICKSORT
+#define BASICQUICKSORT
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class BasicQuickSort
+{
+	/***********************************************************************
+	 * Compile-time quicksort for BasicContext, for any element type and
+	 * comparator. It uses a Hoare partition around the median of three,
+	 * which also splits runs of equal keys evenly, and recurses only into
+	 * the smaller partition. The pivot is parked at the front of the range
+	 * and compared in place, so elements are only ever swapped and
+	 * move-only types work.
+	 ***********************************************************************/
+public:
+	template <typename T, typename Compare>
+	void performSort(std::vector<T>& a, Compare comp)
+	{
+		quicksort(a, 0, a.size(), comp);
+	}
+
+private:
+	/***********************************************************************
+	 * Partition v[start] .. v[end] and return the final position p of the
+	 * pivot: no element of v[start] .. v[p-1] is greater than it and no
+	 * element of v[p+1] .. v[end] is less.
+	 ***********************************************************************/
+	template <typename T, typename Compare>
+	static size_t partition(std::vector<T>& v, size_t start, size_t end, Compare& comp)
+	{
+		size_t mid = start + (end - start) / 2;
+		if (comp(v[mid], v[start]))
+			std::swap(v[mid], v[start]);
+		if (comp(v[end], v[start]))
+			std::swap(v[end], v[start]);
+		if (comp(v[end], v[mid]))
+			std::swap(v[end], v[mid]);
+		// the median goes to the front; v[end] is not less than it, so
+		// neither scan can leave the range
+		if (mid != start)
+			std::swap(v[start], v[mid]);
+		const T& pivot = v[start];
+
+		size_t i = start;
+		size_t j = end + 1;
+		while (true)
+		{
+			while (comp(v[++i], pivot))
+				;
+			while (comp(pivot, v[--j]))
+				;
+			if (i >= j)
+				break;
+			std::swap(v[i], v[j]);
+		}
+		if (j != start)
+			std::swap(v[start], v[j]);
+		return j;
+	}
+
+	// sorts v[lo] .. v[hi-1]
+	template <typename T, typename Compare>
+	static void quicksort(std::vector<T>& v, size_t lo, size_t hi, Compare& comp)
+	{
+		while (hi - lo > 1)
+		{
+			size_t p = partition(v, lo, hi - 1, comp);
+			if (p - lo < hi - p)
+			{
+				quicksort(v, lo, p, comp);
+				lo = p + 1;
+			}
+			else
+			{
+				quicksort(v, p + 1, hi, comp);
+				hi = p;
+			}
+		}
+	}
+};
+
+
+#endif	//#ifndef BASICQUICKSORT
@@ -0,0 +1,283 @@
+#include "MergeSort.h"
+#include "QuickSort.h"
+#include "IntroSort.h"
+#include "RadixSort.h"
+#include "NaturalMergeSort.h"
+#include "ParallelMergeSort.h"
+#include "SampleSort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmarks every SortStrategy over a range of sizes and input
+// distributions and prints one JSON record per run.
+//
+// usage: Benchmark [--min N] [--max N] [--threads N] [--repeat N] [--json FILE]
+//
+// Sizes grow by a factor of ten from --min to --max (1K .. 1B are valid).
+// A run keeps the input, its working copy and a scratch buffer of n ints
+// alive together, so 1B needs about 12 GB plus what the strategy itself
+// allocates. ParallelMergeSort is measured with 1, 2, 4, ... up to
+// --threads threads, and so is SampleSort; compare them at 1 to 128
+// threads with --threads 128. Their thread pools are created for one
+// measurement at a time.
+//
+// peak_rss_kb is the resident set high-water mark of one strategy on one
+// input, measured by resetting it through /proc/self/clear_refs before the
+// run; it is -1 where that is not available.
+//
+// Compiled with -DSORT_INSTRUMENTATION the records also count comparisons,
+// moves, scratch bytes and recursion depth; leave it off for timings.
+
+struct Options
+{
+	size_t minSize = 1000;
+	size_t maxSize = 1000000;
+	unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	int repeat = 3;
+	std::string jsonFile;
+};
+
+struct Distribution
+{
+	const char* name;
+	std::function<void(std::vector<int>&, std::mt19937&)> fill;
+};
+
+struct Result
+{
+	std::string strategy;
+	std::string distribution;
+	size_t size;
+	unsigned threads;
+	double seconds;
+	long peakRssKb;
+	SortStats stats;
+};
+
+// classic O(n^2) cases of the Lomuto QuickSort are skipped above this size
+static const size_t QUADRATIC_LIMIT = 20000;
+
+static void fillZipf(std::vector<int>& a, std::mt19937& rng)
+{
+	const int keys = 1 << 16;
+	const double exponent = 1.1;
+	std::vector<double> cdf(keys);
+	double sum = 0.0;
+	for (int k = 0; k < keys; k++)
+	{
+		sum += 1.0 / std::pow(k + 1, exponent);
+		cdf[k] = sum;
+	}
+	std::uniform_real_distribution<double> uniform(0.0, sum);
+	for (int& x : a)
+	{
+		x = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+	}
+}
+
+static std::vector<Distribution> distributions()
+{
+	return {
+		{"uniform", [](std::vector<int>& a, std::mt19937& rng)
+			{
+				for (int& x : a)
+					x = static_cast<int>(rng());
+			}},
+		{"sorted", [](std::vector<int>& a, std::mt19937&)
+			{
+				for (size_t i = 0; i < a.size(); i++)
+					a[i] = static_cast<int>(i);
+			}},
+		{"reversed", [](std::vector<int>& a, std::mt19937&)
+			{
+				for (size_t i = 0; i < a.size(); i++)
+					a[i] = static_cast<int>(a.size() - i);
+			}},
+		{"organ-pipe", [](std::vector<int>& a, std::mt19937&)
+			{
+				for (size_t i = 0; i < a.size(); i++)
+					a[i] = static_cast<int>(std::min(i, a.size() - i));
+			}},
+		{"few-unique", [](std::vector<int>& a, std::mt19937& rng)
+			{
+				for (int& x : a)
+					x = static_cast<int>(rng() % 16);
+			}},
+		{"sawtooth", [](std::vector<int>& a, std::mt19937&)
+			{
+				for (size_t i = 0; i < a.size(); i++)
+					a[i] = static_cast<int>(i % 1024);
+			}},
+		{"zipf", fillZipf},
+	};
+}
+
+// value of a "Name:   123 kB" line of /proc/self/status, or -1
+static long readStatusKb(const char* field)
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	size_t length = std::strlen(field);
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, length, field) == 0 && line.size() > length && line[length] == ':')
+			return std::strtol(line.c_str() + length + 1, nullptr, 10);
+	}
+	return -1;
+}
+
+// lowers the peak RSS to the current RSS, so VmHWM covers only what
+// follows; false if the kernel does not support it
+static bool resetPeakRss()
+{
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+	clearRefs.flush();
+	return static_cast<bool>(clearRefs);
+}
+
+static Result measure(SortStrategy& strategy, unsigned threads, const Distribution& distribution,
+	const std::vector<int>& input, int repeat)
+{
+	bool peakTracked = resetPeakRss();
+	ScratchArena scratch;
+	std::vector<int> work;
+	double best = 1e300;
+	SortStats stats;
+	for (int r = 0; r < repeat; r++)
+	{
+		work = input;
+		auto start = std::chrono::steady_clock::now();
+		strategy.measuredSort(work, scratch);
+		auto stop = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double>(stop - start).count());
+		stats = strategy.getLastStats();
+
+		if (!std::is_sorted(work.begin(), work.end()))
+		{
+			std::cerr << strategy.getName() << " failed on " << distribution.name << std::endl;
+			std::exit(1);
+		}
+	}
+	long peakRssKb = peakTracked ? readStatusKb("VmHWM") : -1;
+	return {strategy.getName(), distribution.name, input.size(), threads, best, peakRssKb, stats};
+}
+
+static std::string toJson(const std::vector<Result>& results)
+{
+	std::ostringstream out;
+	out << "[\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		out << "  {\"strategy\": \"" << r.strategy << "\""
+			<< ", \"distribution\": \"" << r.distribution << "\""
+			<< ", \"n\": " << r.size
+			<< ", \"threads\": " << r.threads
+			<< ", \"seconds\": " << r.seconds
+			<< ", \"ns_per_element\": " << r.seconds * 1e9 / std::max<size_t>(r.size, 1)
+			<< ", \"peak_rss_kb\": " << r.peakRssKb
+			<< ", \"comparisons\": " << r.stats.comparisons
+			<< ", \"moves\": " << r.stats.moves
+			<< ", \"scratch_bytes\": " << r.stats.scratchBytes
+			<< ", \"max_depth\": " << r.stats.maxDepth
+			<< "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "]\n";
+	return out.str();
+}
+
+static Options parseOptions(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--min") == 0)
+			options.minSize = std::strtoull(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--max") == 0)
+			options.maxSize = std::strtoull(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			options.maxThreads = std::max(1ul, std::strtoul(argv[i + 1], nullptr, 10));
+		else if (std::strcmp(argv[i], "--repeat") == 0)
+			options.repeat = std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--json") == 0)
+			options.jsonFile = argv[i + 1];
+	}
+	return options;
+}
+
+int main(int argc, char** argv)
+{
+	Options options = parseOptions(argc, argv);
+
+	MergeSort topDownMergeSort;
+	MergeSort bottomUpMergeSort(MergeSort::Mode::BottomUp);
+	QuickSort quickSort;
+	IntroSort introSort;
+	RadixSort radixSort;
+	NaturalMergeSort naturalMergeSort;
+	std::vector<SortStrategy*> serial = {
+		&topDownMergeSort, &bottomUpMergeSort, &quickSort, &introSort, &radixSort, &naturalMergeSort
+	};
+
+	std::vector<std::function<std::unique_ptr<SortStrategy>(unsigned)>> parallel = {
+		[](unsigned threads) { return std::make_unique<ParallelMergeSort>(threads); },
+		[](unsigned threads) { return std::make_unique<SampleSort>(threads); },
+	};
+
+	std::vector<Result> results;
+	std::mt19937 rng(42);
+	for (size_t n = options.minSize; n <= options.maxSize; n *= 10)
+	{
+		for (const Distribution& distribution : distributions())
+		{
+			std::vector<int> input(n);
+			distribution.fill(input, rng);
+
+			for (SortStrategy* strategy : serial)
+			{
+				if (strategy == &quickSort && n > QUADRATIC_LIMIT && std::strcmp(distribution.name, "uniform") != 0)
+					continue;
+				results.push_back(measure(*strategy, 1, distribution, input, options.repeat));
+				std::cerr << results.back().strategy << " " << distribution.name << " n=" << n << ": "
+					<< results.back().seconds * 1e9 / n << " ns/element" << std::endl;
+			}
+			for (unsigned t = 1; t <= options.maxThreads; t *= 2)
+			{
+				for (const auto& create : parallel)
+				{
+					// only this measurement's pool is running
+					std::unique_ptr<SortStrategy> strategy = create(t);
+					results.push_back(measure(*strategy, t, distribution, input, options.repeat));
+					std::cerr << results.back().strategy << " x" << t << " " << distribution.name
+						<< " n=" << n << ": " << results.back().seconds * 1e9 / n << " ns/element" << std::endl;
+				}
+			}
+		}
+	}
+
+	std::string json = toJson(results);
+	if (options.jsonFile.empty())
+	{
+		std::cout << json;
+	}
+	else
+	{
+		std::ofstream(options.jsonFile) << json;
+	}
+
+	return 0;
+}
@@ -1,5 +1,9 @@
 #include "Policy.h"
 #include "Context.h"
+#include "StringContext.h"
+#include "BasicContext.h"
+#include "BasicMergeSort.h"
+#include "BasicQuickSort.h"
 
 #include <string>
 #include <vector>
@@ -8,12 +12,25 @@
 #include <optional>
 #include <random>
 #include <algorithm>
+#include <functional>
+#include <thread>
 
 std::vector<int> createIntegerArray();
 std::vector<int> scrambleArray(std::vector<int>);
 void printIntegerArray(std::vector<int>&);
 void simulateRuntimeConfigurationChange(Policy*);
 
+// has no default constructor, which the templated sorts do not need
+struct Order
+{
+	std::string sku;
+	double price;
+
+	Order(std::string sku, double price) : sku(std::move(sku)), price(price)
+	{
+	}
+};
+
 int main()
 {
 	// TODO 3: implement the Context class with required methods and attributes
@@ -21,20 +38,98 @@ int main()
 	
 	Context* sortingContext = new Context();
 	Policy* policy = new Policy(sortingContext);
+	policy->setThreadBudget(std::thread::hardware_concurrency());
 
 	std::vector<int> array = createIntegerArray();
 
 	for (int i = 0; i < 10; i++)
 	{
 		array = scrambleArray(array);
-		sortingContext->setArray(array);
 		simulateRuntimeConfigurationChange(policy);
 		std::cout << "Unsorted Array a = ";
 		printIntegerArray(array);
-		sortingContext->sort();
+		sortingContext->sortInPlace(array);
 		std::cout << "Sorted Array a = ";
-		printIntegerArray(sortingContext->getArray());
+		printIntegerArray(array);
+	}
+
+	// when only a few values change per round, keep the array sorted and
+	// merge the changes in
+	sortingContext->setArray(array);
+	sortingContext->setIncremental(true);
+	sortingContext->setDeltaThreshold(0.25);
+	for (int i = 0; i < 10; i++)
+	{
+		DeltaBatch batch;
+		batch.insert(rand() % 100);
+		batch.erase(sortingContext->getArray()[rand() % sortingContext->getArray().size()]);
+		batch.update(sortingContext->getArray().front(), rand() % 100);
+		sortingContext->applyDelta(batch);
 	}
+	sortingContext->setIncremental(false);
+	std::cout << "Incrementally sorted a = ";
+	printIntegerArray(sortingContext->getArray());
+	std::cout << "Delta work: " << sortingContext->getDeltaStats() << std::endl;
+
+	// let the policy look at the data instead: an almost sorted array
+	std::vector<int> presorted = array;
+	std::swap(presorted.front(), presorted.back());
+	policy->configure(presorted);
+	sortingContext->setArray(std::move(presorted));
+	std::cout << "Profile: " << policy->getLastProfile() << std::endl;
+	std::cout << "Chosen strategy: " << policy->getLastChoice() << std::endl;
+	sortingContext->sort();
+	std::cout << "Sorted Array a = ";
+	printIntegerArray(sortingContext->getArray());
+	std::cout << "Sort cost: " << sortingContext->getLastStats() << std::endl;
+
+	// or let it choose from explicit budgets and the strategies' history
+	Policy::Budget budget;
+	budget.seconds = 0.001;
+	budget.scratchBytes = 0;
+	policy->configure(array.size(), budget);
+	std::cout << "Chosen for the budget: " << policy->getLastChoice() << std::endl;
+
+	// callers that only need the smallest values do not have to sort
+	policy->configureSelection(5, array.size());
+	std::cout << "Five smallest = ";
+	std::vector<int> smallest = sortingContext->topK(5);
+	printIntegerArray(smallest);
+	// the median is far from the front, so configure for that k
+	policy->configureSelection(array.size() / 2, array.size());
+	std::cout << "Median = " << sortingContext->nthElement(array.size() / 2) << std::endl;
+	// string keys go through their own context, chosen by the same policy
+	StringContext* stringContext = new StringContext();
+	policy->setStringContext(stringContext);
+	stringContext->setArray(std::vector<std::string>{"strategy", "policy", "context", "sort", "string", "pool"});
+	policy->configure(stringContext->getArray());
+	stringContext->sort();
+	std::cout << "Sorted strings (" << policy->getLastStringChoice() << ") = {";
+	for (size_t i = 0; i < stringContext->getArray().size(); i++)
+		std::cout << (i > 0 ? "," : "") << stringContext->getArray()[i];
+	std::cout << "}" << std::endl;
+	policy->setStringContext(nullptr);
+	delete stringContext;
+
+	// other element types and orders are fixed at compile time
+	auto byPrice = [](const Order& a, const Order& b) { return a.price < b.price; };
+	BasicContext<Order, BasicMergeSort, decltype(byPrice)> orderContext(BasicMergeSort(), byPrice);
+	orderContext.setArray(std::vector<Order>{{"SKU-7", 19.99}, {"SKU-2", 4.5}, {"SKU-9", 12.0}, {"SKU-4", 4.5}});
+	orderContext.sort();
+	std::cout << "Orders by price = {";
+	for (size_t i = 0; i < orderContext.getArray().size(); i++)
+		std::cout << (i > 0 ? "," : "") << orderContext.getArray()[i].sku << ":" << orderContext.getArray()[i].price;
+	std::cout << "}" << std::endl;
+
+	BasicContext<double, BasicQuickSort, std::greater<double>> priceContext;
+	priceContext.setArray(std::vector<double>{2.5, 9.75, -1.0, 3.25, 9.75, 0.5});
+	priceContext.sort();
+	std::cout << "Prices descending = {";
+	for (size_t i = 0; i < priceContext.getArray().size(); i++)
+		std::cout << (i > 0 ? "," : "") << priceContext.getArray()[i];
+	std::cout << "}" << std::endl;
+
+	std::cout << "Peak scratch memory: " << sortingContext->getPeakScratchBytes() << " bytes" << std::endl;
 	
 	if(sortingContext != nullptr)
 		delete sortingContext;
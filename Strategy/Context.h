@@ -1,36 +1,224 @@
 #ifndef _CONTEXT_H_
 #define _CONTEXT_H_
 
+#include "BasicContext.h"
+#include "DeltaMerge.h"
+#include "IntroSelect.h"
+#include "KeyValueSort.h"
+#include "SelectStrategy.h"
+#include "TopK.h"
+#include "SortHistory.h"
 #include "SortStrategy.h"
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
-class Context 
+// Adapts a runtime SortStrategy to the compile-time strategy interface
+// of BasicContext. It owns the scratch arena that is handed to every
+// sort, so the memory is reused across sort() calls. Every sort is
+// measured and, if a history is attached, recorded in it.
+class DynamicSort
 {
 	private:
-		SortStrategy* sortAlgorithm;
-		std::vector<int> array;
+		SortStrategy* sortAlgorithm = nullptr;
+		ScratchArena scratch;
+		SortHistory* history = nullptr;
 
 	public:
-		void setSortAlgorithm(SortStrategy* sortStrategy) 
+		void setSortAlgorithm(SortStrategy* sortStrategy)
 		{
 			sortAlgorithm = sortStrategy;
 		}
-		
+
+		void setSortHistory(SortHistory* sortHistory)
+		{
+			history = sortHistory;
+		}
+
+		void performSort(std::vector<int>& a, std::less<int>)
+		{
+			sortAlgorithm->measuredSort(a, scratch);
+			record(a.size());
+		}
+
+		void performSort(std::span<int> a)
+		{
+			sortAlgorithm->measuredSort(a, scratch);
+			record(a.size());
+		}
+
+		// for internal helper sorts that should not show up in
+		// getLastStats() or the history
+		void performUnrecordedSort(std::span<int> a)
+		{
+			sortAlgorithm->performSort(a, scratch);
+		}
+
+		const SortStats& getLastStats() const
+		{
+			return sortAlgorithm->getLastStats();
+		}
+
+		const ScratchArena& getScratch() const
+		{
+			return scratch;
+		}
+
+	private:
+		void record(size_t n)
+		{
+			if (history != nullptr)
+			{
+				history->record(sortAlgorithm, n, sortAlgorithm->getLastStats());
+			}
+		}
+};
+
+class Context : public BasicContext<int, DynamicSort>
+{
+	private:
+		KeyValueSort keyValueSort;
+		IntroSelect defaultSelect;
+		SelectStrategy* selectAlgorithm = &defaultSelect;
+		DeltaMerge deltaMerge;
+		bool incremental = false;
+
+	public:
+		void setSortAlgorithm(SortStrategy* sortStrategy) 
+		{
+			getSortAlgorithm().setSortAlgorithm(sortStrategy);
+		}
+
+		// In incremental mode the array is kept sorted: a new array is
+		// sorted when it is set, and changes are merged in with
+		// applyDelta() instead of sorting everything again.
+		void setIncremental(bool enable)
+		{
+			incremental = enable;
+			if (incremental)
+			{
+				sort();
+			}
+		}
+
 		void setArray(std::vector<int>& arr)
 		{
-			array = arr;
+			BasicContext::setArray(arr);
+			if (incremental)
+			{
+				sort();
+			}
 		}
-		
-		void sort() 
+
+		void setArray(std::vector<int>&& arr)
+		{
+			BasicContext::setArray(std::move(arr));
+			if (incremental)
+			{
+				sort();
+			}
+		}
+
+		// Applies a batch of changes to the sorted array. Batches larger
+		// than the threshold fraction of the array are applied with a
+		// full sort instead of a merge.
+		void applyDelta(const DeltaBatch& batch)
+		{
+			if (!incremental)
+			{
+				setIncremental(true);
+			}
+			deltaMerge.apply(getArray(), batch,
+				[this](std::span<int> delta) { getSortAlgorithm().performUnrecordedSort(delta); },
+				[this](std::span<int> all) { getSortAlgorithm().performSort(all); });
+		}
+
+		void setDeltaThreshold(double fraction)
+		{
+			deltaMerge.setThreshold(fraction);
+		}
+
+		// work done by merged and by fully sorted batches, and what each
+		// saved compared with re-sorting the whole array every time
+		const DeltaStats& getDeltaStats() const
+		{
+			return deltaMerge.getStats();
+		}
+
+		void setSortHistory(SortHistory* history)
+		{
+			getSortAlgorithm().setSortHistory(history);
+		}
+
+		// counters and wall time of the most recent sort
+		const SortStats& getLastStats()
+		{
+			return getSortAlgorithm().getLastStats();
+		}
+
+		// largest amount of scratch memory any sort has asked for so far
+		size_t getPeakScratchBytes()
+		{
+			return getSortAlgorithm().getScratch().getPeakBytes();
+		}
+
+		// Sorts the caller's memory in place with the current strategy,
+		// without copying it into the context.
+		void sortInPlace(std::span<int> data)
+		{
+			getSortAlgorithm().performSort(data);
+		}
+
+		// Indices that put the context's array in ascending order; equal
+		// keys keep their original order.
+		std::vector<uint32_t> argsort()
+		{
+			return keyValueSort.argsort(getArray());
+		}
+
+		// Sorts keys and reorders the payload column the same way.
+		template <typename Payload>
+		void sortByKey(std::span<int> keys, std::span<Payload> values)
 		{
-			sortAlgorithm->performSort(array);
+			keyValueSort.sortByKey(keys, values);
 		}
 
-		std::vector<int>& getArray()
+		// nullptr goes back to IntroSelect, which is also used until a
+		// strategy is set
+		void setSelectAlgorithm(SelectStrategy* selectStrategy)
 		{
-			return array;
+			selectAlgorithm = selectStrategy != nullptr ? selectStrategy : &defaultSelect;
 		}
 
+		// Value at position k of the sorted array; the array ends up
+		// partitioned around it.
+		int nthElement(size_t k)
+		{
+			if (k >= getArray().size())
+			{
+				throw std::out_of_range("Context::nthElement: k is past the end of the array");
+			}
+			selectAlgorithm->nthElement(getArray(), k);
+			return getArray()[k];
+		}
+
+		// Puts the k smallest values at the front of the array, ascending.
+		void partialSort(size_t k)
+		{
+			selectAlgorithm->partialSort(getArray(), k);
+		}
+
+		// The k smallest values in ascending order, leaving the array as
+		// it is.
+		std::vector<int> topK(size_t k)
+		{
+			TopK top(k);
+			top.push(std::span<const int>(getArray()));
+			return top.result();
+		}
 };
 
 #endif // _CONTEXT_H_
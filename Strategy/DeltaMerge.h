@@ -0,0 +1,277 @@
+#ifndef DELTAMERGE
+#define DELTAMERGE
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <ostream>
+#include <span>
+#include <utility>
+#include <vector>
+#include "SortingNetwork.h"
+
+/***********************************************************************
+ * Changes to a sorted array collected between two rounds. The array
+ * holds plain values, so an update replaces one occurrence of the old
+ * value with the new one, and a delete of a value that is not in the
+ * array is ignored. An update whose old value is not in the array is
+ * ignored as a whole; it does not turn into an insert. When deletes and
+ * updates ask for more occurrences of a value than the array holds,
+ * deletes are served first and then updates in the order they were
+ * added.
+ ***********************************************************************/
+struct DeltaBatch
+{
+	std::vector<int> inserts;
+	std::vector<int> deletes;
+	std::vector<std::pair<int, int>> updates;	// (old value, new value)
+
+	void insert(int value)
+	{
+		inserts.push_back(value);
+	}
+
+	void erase(int value)
+	{
+		deletes.push_back(value);
+	}
+
+	void update(int oldValue, int newValue)
+	{
+		updates.emplace_back(oldValue, newValue);
+	}
+
+	size_t size() const
+	{
+		return inserts.size() + deletes.size() + 2 * updates.size();
+	}
+
+	void clear()
+	{
+		inserts.clear();
+		deletes.clear();
+		updates.clear();
+	}
+};
+
+// Work done by one way of applying batches. Comparisons are estimated
+// from the sizes involved (n log2 n for a sort, n for a linear pass) and
+// set against re-sorting the whole array, which is what setArray() and
+// sort() would have cost for the same batch.
+struct DeltaModeStats
+{
+	size_t batches = 0;
+	size_t deltaElements = 0;
+	double comparisons = 0.0;
+	double fullSortComparisons = 0.0;
+	double seconds = 0.0;
+
+	double saved() const
+	{
+		return fullSortComparisons - comparisons;
+	}
+};
+
+struct DeltaStats
+{
+	DeltaModeStats merge;		// delta sorted and merged in
+	DeltaModeStats fullSort;	// delta too large, array sorted again
+};
+
+inline std::ostream& operator<<(std::ostream& out, const DeltaModeStats& stats)
+{
+	return out << "batches=" << stats.batches
+		<< " delta=" << stats.deltaElements
+		<< " comparisons=" << stats.comparisons
+		<< " saved=" << stats.saved()
+		<< " seconds=" << stats.seconds;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const DeltaStats& stats)
+{
+	return out << "merge: " << stats.merge << ", full sort: " << stats.fullSort;
+}
+
+/***********************************************************************
+ * Keeps an array sorted across batches of changes.
+ *
+ * Removed values are sorted and taken out in one pass over the array,
+ * added values are sorted and merged in with a linear merge, so a batch
+ * of d changes costs d log d + n instead of n log n. Once a batch grows
+ * beyond the threshold fraction of the array the merge no longer pays
+ * off and the whole array is sorted again.
+ ***********************************************************************/
+class DeltaMerge
+{
+public:
+	void setThreshold(double fraction)
+	{
+		threshold = fraction;
+	}
+
+	double getThreshold() const
+	{
+		return threshold;
+	}
+
+	const DeltaStats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = DeltaStats();
+	}
+
+	// sortDelta(std::span<int>) sorts the removed and the added values,
+	// sortAll(std::span<int>) the whole array on the fallback path;
+	// sorted must be in ascending order.
+	template <typename SortDelta, typename SortAll>
+	void apply(std::vector<int>& sorted, const DeltaBatch& batch, SortDelta sortDelta, SortAll sortAll)
+	{
+		auto start = std::chrono::steady_clock::now();
+		size_t n = sorted.size();
+		size_t d = batch.size();
+
+		removals.assign(batch.deletes.begin(), batch.deletes.end());
+		for (const auto& [oldValue, newValue] : batch.updates)
+		{
+			removals.push_back(oldValue);
+		}
+		sortDelta(std::span<int>(removals));
+		removeSorted(sorted);
+
+		additions.assign(batch.inserts.begin(), batch.inserts.end());
+		collectUpdates(batch);
+
+		DeltaModeStats* mode;
+		if (static_cast<double>(d) > threshold * static_cast<double>(n))
+		{
+			mode = &stats.fullSort;
+			sorted.insert(sorted.end(), additions.begin(), additions.end());
+			sortAll(std::span<int>(sorted));
+			mode->comparisons += sortCost(removals.size()) + n + sortCost(sorted.size());
+		}
+		else
+		{
+			mode = &stats.merge;
+			sortDelta(std::span<int>(additions));
+			mergeSorted(sorted);
+			mode->comparisons += sortCost(removals.size()) + sortCost(additions.size()) + n + sorted.size();
+		}
+
+		mode->batches++;
+		mode->deltaElements += d;
+		mode->fullSortComparisons += sortCost(sorted.size());
+		mode->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	double threshold = 0.125;
+	DeltaStats stats;
+
+	// kept between batches so steady rounds do not allocate
+	std::vector<int> removals;
+	std::vector<int> additions;
+	std::vector<int> buffer;
+	std::vector<int> unmatched;		// removals not found in the array, ascending
+	std::vector<std::pair<int, size_t>> updateOrder;
+	std::vector<char> dropped;
+
+	static double sortCost(size_t n)
+	{
+		return n > 1 ? n * std::log2(static_cast<double>(n)) : 0.0;
+	}
+
+	// drops one occurrence of every value in removals, in place, and
+	// collects the removals that found nothing in unmatched
+	void removeSorted(std::vector<int>& sorted)
+	{
+		unmatched.clear();
+		if (removals.empty())
+		{
+			return;
+		}
+		size_t out = 0;
+		size_t r = 0;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			while (r < removals.size() && removals[r] < sorted[i])
+			{
+				unmatched.push_back(removals[r++]);	// not in the array
+			}
+			if (r < removals.size() && removals[r] == sorted[i])
+			{
+				r++;
+				continue;
+			}
+			sorted[out++] = sorted[i];
+		}
+		unmatched.insert(unmatched.end(), removals.begin() + r, removals.end());
+		sorted.resize(out);
+	}
+
+	// Adds the new values of the updates whose old value was removed.
+	// Deletes are served first, so every unmatched removal of a value is
+	// charged to the last update of that value that is not charged yet.
+	void collectUpdates(const DeltaBatch& batch)
+	{
+		dropped.assign(batch.updates.size(), 0);
+		if (!unmatched.empty() && !batch.updates.empty())
+		{
+			updateOrder.clear();
+			for (size_t u = 0; u < batch.updates.size(); u++)
+			{
+				updateOrder.emplace_back(batch.updates[u].first, u);
+			}
+			// by value, the latest update first
+			std::sort(updateOrder.begin(), updateOrder.end(), [](const auto& x, const auto& y)
+			{
+				return x.first < y.first || (x.first == y.first && x.second > y.second);
+			});
+			size_t u = 0;
+			for (size_t r = 0; r < unmatched.size(); r++)
+			{
+				while (u < updateOrder.size() && updateOrder[u].first < unmatched[r])
+				{
+					u++;
+				}
+				// unmatched deletes of the value have run out of updates
+				if (u < updateOrder.size() && updateOrder[u].first == unmatched[r])
+				{
+					dropped[updateOrder[u++].second] = 1;
+				}
+			}
+		}
+		for (size_t u = 0; u < batch.updates.size(); u++)
+		{
+			if (!dropped[u])
+			{
+				additions.push_back(batch.updates[u].second);
+			}
+		}
+	}
+
+	void mergeSorted(std::vector<int>& sorted)
+	{
+		if (additions.empty())
+		{
+			return;
+		}
+		buffer.resize(sorted.size() + additions.size());
+		if (buffer.size() <= static_cast<size_t>(INT_MAX))
+		{
+			SortingNetwork::merge(sorted.data(), static_cast<int>(sorted.size()),
+				additions.data(), static_cast<int>(additions.size()), buffer.data());
+		}
+		else
+		{
+			std::merge(sorted.begin(), sorted.end(), additions.begin(), additions.end(), buffer.begin());
+		}
+		sorted.swap(buffer);
+	}
+};
+
+#endif	//#ifndef DELTAMERGE
@@ -0,0 +1,396 @@
+#ifndef EXTERNALSORT
+#define EXTERNALSORT
+
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "SortStrategy.h"
+
+/***********************************************************************
+ * External mergesort for files of native-endian 32-bit integers that do
+ * not fit into memory.
+ *
+ * Phase 1 streams the input in chunks that fit the memory budget, sorts
+ * each chunk with an in-memory SortStrategy and writes it as a run file.
+ * Phase 2 merges up to fanIn runs at a time through a loser tree, reading
+ * and writing in large sequential blocks. With read-ahead enabled every
+ * run loads its next block asynchronously while the current one is
+ * merged.
+ ***********************************************************************/
+class ExternalSort
+{
+public:
+	ExternalSort(SortStrategy* runSorter, size_t memoryBudgetBytes, bool readAhead = true)
+		: runSorter(runSorter), memoryBudget(std::max(memoryBudgetBytes, MIN_BUDGET)), readAhead(readAhead)
+	{
+	}
+
+	void setMemoryBudget(size_t bytes)
+	{
+		memoryBudget = std::max(bytes, MIN_BUDGET);
+	}
+
+	size_t getMemoryBudget() const
+	{
+		return memoryBudget;
+	}
+
+	void setReadAhead(bool enable)
+	{
+		readAhead = enable;
+	}
+
+	void setRunSorter(SortStrategy* sorter)
+	{
+		runSorter = sorter;
+	}
+
+	size_t getRunCount() const
+	{
+		return runCount;
+	}
+
+	void sortFile(const std::string& input, const std::string& output)
+	{
+		// every intermediate file is removed if the sort does not finish
+		TemporaryFiles temporaries;
+		std::vector<std::string> runs = createRuns(input, output, temporaries);
+		runCount = runs.size();
+
+		// merge in passes until a single run is left
+		int pass = 0;
+		while (runs.size() > 1)
+		{
+			size_t fanIn = maxFanIn();
+			std::vector<std::string> merged;
+			for (size_t first = 0; first < runs.size(); first += fanIn)
+			{
+				size_t last = std::min(first + fanIn, runs.size());
+				std::vector<std::string> group(runs.begin() + first, runs.begin() + last);
+				std::string target = output + ".pass" + std::to_string(pass) + "." + std::to_string(merged.size());
+				temporaries.add(target);
+				mergeRuns(group, target);
+				for (const std::string& run : group)
+				{
+					temporaries.remove(run);
+				}
+				merged.push_back(target);
+			}
+			runs = std::move(merged);
+			pass++;
+		}
+
+		if (runs.empty())
+		{
+			File(output, "wb");
+		}
+		else if (std::rename(runs[0].c_str(), output.c_str()) != 0)
+		{
+			throw std::runtime_error("ExternalSort: cannot create " + output);
+		}
+		else
+		{
+			temporaries.release(runs[0]);
+		}
+	}
+
+private:
+	static constexpr size_t MIN_BUDGET = 1 << 20;
+	static constexpr size_t MIN_BLOCK = 1 << 14;	// ints per run buffer
+
+	SortStrategy* runSorter;
+	size_t memoryBudget;
+	bool readAhead;
+	size_t runCount = 0;
+
+	struct File
+	{
+		std::FILE* handle;
+
+		File(const std::string& path, const char* mode) : handle(std::fopen(path.c_str(), mode))
+		{
+			if (handle == nullptr)
+			{
+				throw std::runtime_error("ExternalSort: cannot open " + path);
+			}
+		}
+
+		~File()
+		{
+			std::fclose(handle);
+		}
+
+		File(const File&) = delete;
+		File& operator=(const File&) = delete;
+
+		// Reads up to count ints and returns how many; a read error or a
+		// file that ends inside an int is reported, not dropped
+		size_t read(int* data, size_t count)
+		{
+			size_t bytes = std::fread(data, 1, count * sizeof(int), handle);
+			if (std::ferror(handle))
+			{
+				throw std::runtime_error("ExternalSort: read failed");
+			}
+			if (bytes % sizeof(int) != 0)
+			{
+				throw std::runtime_error("ExternalSort: file size is not a multiple of " + std::to_string(sizeof(int)) + " bytes");
+			}
+			return bytes / sizeof(int);
+		}
+
+		void write(const int* data, size_t count)
+		{
+			if (std::fwrite(data, sizeof(int), count, handle) != count)
+			{
+				throw std::runtime_error("ExternalSort: write failed");
+			}
+		}
+	};
+
+	/***********************************************************************
+	 * Paths of the run and pass files that exist right now; whatever is
+	 * still listed when the guard goes away is deleted.
+	 ***********************************************************************/
+	class TemporaryFiles
+	{
+	public:
+		TemporaryFiles() = default;
+
+		~TemporaryFiles()
+		{
+			for (const std::string& path : paths)
+			{
+				std::remove(path.c_str());
+			}
+		}
+
+		TemporaryFiles(const TemporaryFiles&) = delete;
+		TemporaryFiles& operator=(const TemporaryFiles&) = delete;
+
+		void add(const std::string& path)
+		{
+			paths.push_back(path);
+		}
+
+		// deletes path now
+		void remove(const std::string& path)
+		{
+			std::remove(path.c_str());
+			release(path);
+		}
+
+		// path is no longer temporary
+		void release(const std::string& path)
+		{
+			paths.erase(std::remove(paths.begin(), paths.end(), path), paths.end());
+		}
+
+	private:
+		std::vector<std::string> paths;
+	};
+
+	// one block per run and one for the output, doubled with read-ahead
+	size_t maxFanIn() const
+	{
+		size_t blocks = memoryBudget / (MIN_BLOCK * sizeof(int));
+		size_t perRun = readAhead ? 2 : 1;
+		return std::max<size_t>(2, (blocks - 1) / perRun);
+	}
+
+	std::vector<std::string> createRuns(const std::string& input, const std::string& output,
+		TemporaryFiles& temporaries)
+	{
+		File in(input, "rb");
+		std::vector<int> chunk(memoryBudget / sizeof(int));
+		ScratchArena scratch;
+		std::vector<std::string> runs;
+		while (true)
+		{
+			chunk.resize(chunk.capacity());
+			size_t count = in.read(chunk.data(), chunk.size());
+			if (count == 0)
+			{
+				break;
+			}
+			chunk.resize(count);
+			runSorter->performSort(chunk, scratch);
+
+			std::string run = output + ".run" + std::to_string(runs.size());
+			temporaries.add(run);
+			File(run, "wb").write(chunk.data(), chunk.size());
+			runs.push_back(run);
+		}
+		return runs;
+	}
+
+	/***********************************************************************
+	 * Sequential reader of one sorted run with optional asynchronous
+	 * read-ahead of the following block.
+	 ***********************************************************************/
+	class RunReader
+	{
+	public:
+		RunReader(const std::string& path, size_t blockSize, bool readAhead)
+			: file(path, "rb"), current(blockSize), readAhead(readAhead)
+		{
+			count = file.read(current.data(), current.size());
+			if (readAhead)
+			{
+				next.resize(blockSize);
+				startReadAhead();
+			}
+		}
+
+		~RunReader()
+		{
+			if (pending.valid())
+			{
+				pending.wait();
+			}
+		}
+
+		bool exhausted() const
+		{
+			return position == count;
+		}
+
+		int value() const
+		{
+			return current[position];
+		}
+
+		void advance()
+		{
+			if (++position < count)
+			{
+				return;
+			}
+			position = 0;
+			if (readAhead)
+			{
+				count = pending.get();
+				std::swap(current, next);
+				if (count > 0)
+				{
+					startReadAhead();
+				}
+			}
+			else
+			{
+				count = file.read(current.data(), current.size());
+			}
+		}
+
+	private:
+		File file;
+		std::vector<int> current;
+		std::vector<int> next;
+		std::future<size_t> pending;
+		size_t position = 0;
+		size_t count = 0;
+		bool readAhead;
+
+		void startReadAhead()
+		{
+			pending = std::async(std::launch::async, [this] { return file.read(next.data(), next.size()); });
+		}
+	};
+
+	/***********************************************************************
+	 * Tournament tree of losers over k runs: tree[0] holds the index of
+	 * the smallest current value, every inner node the loser of the match
+	 * played there. Replacing the winner replays only one leaf-to-root
+	 * path, i.e. log2(k) comparisons per element.
+	 ***********************************************************************/
+	class LoserTree
+	{
+	public:
+		explicit LoserTree(std::vector<std::unique_ptr<RunReader>>& runs)
+			: runs(runs), k(static_cast<int>(runs.size())), tree(std::max(k, 1), k)
+		{
+			// index k is a virtual source that beats everything, so the
+			// initial passes leave the real sources behind as losers
+			for (int s = k - 1; s >= 0; s--)
+			{
+				replay(s);
+			}
+		}
+
+		int winner() const
+		{
+			return tree[0];
+		}
+
+		void replay(int s)
+		{
+			for (int t = (s + k) / 2; t > 0; t /= 2)
+			{
+				if (beats(tree[t], s))
+				{
+					std::swap(s, tree[t]);
+				}
+			}
+			tree[0] = s;
+		}
+
+	private:
+		std::vector<std::unique_ptr<RunReader>>& runs;
+		int k;
+		std::vector<int> tree;
+
+		// exhausted runs lose against everything; ties go to the lower index
+		bool beats(int a, int b) const
+		{
+			if (a == k || b == k)
+			{
+				return a == k;
+			}
+			if (runs[a]->exhausted() || runs[b]->exhausted())
+			{
+				return !runs[a]->exhausted();
+			}
+			int x = runs[a]->value();
+			int y = runs[b]->value();
+			return x < y || (x == y && a < b);
+		}
+	};
+
+	void mergeRuns(const std::vector<std::string>& group, const std::string& target)
+	{
+		size_t perRun = readAhead ? 2 : 1;
+		size_t blockSize = std::max(MIN_BLOCK, memoryBudget / sizeof(int) / (group.size() * perRun + 1));
+
+		std::vector<std::unique_ptr<RunReader>> readers;
+		for (const std::string& run : group)
+		{
+			readers.push_back(std::make_unique<RunReader>(run, blockSize, readAhead));
+		}
+
+		File out(target, "wb");
+		std::vector<int> buffer;
+		buffer.reserve(blockSize);
+
+		LoserTree tree(readers);
+		while (!readers[tree.winner()]->exhausted())
+		{
+			int w = tree.winner();
+			buffer.push_back(readers[w]->value());
+			if (buffer.size() == blockSize)
+			{
+				out.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+			readers[w]->advance();
+			tree.replay(w);
+		}
+		out.write(buffer.data(), buffer.size());
+	}
+};
+
+#endif	//#ifndef EXTERNALSORT
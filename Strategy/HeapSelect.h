@@ -0,0 +1,68 @@
+#ifndef HEAPSELECT
+#define HEAPSELECT
+
+#include <algorithm>
+#include <span>
+#include <vector>
+#include "SelectStrategy.h"
+#include "TopK.h"
+
+class HeapSelect : public SelectStrategy
+{
+	/***********************************************************************
+	 * Selection through a bounded heap of k elements: O(n log k) and a
+	 * single read pass, so it wins when k is much smaller than n. The
+	 * array is then reordered in one more pass so that the k smallest
+	 * values come first.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "HeapSelect";
+	}
+
+	void nthElement(std::span<int> a, size_t k) override
+	{
+		if (k < a.size())
+		{
+			partialSort(a, k + 1);
+		}
+	}
+
+	void partialSort(std::span<int> a, size_t k) override
+	{
+		k = std::min(k, a.size());
+		if (k == 0)
+		{
+			return;
+		}
+
+		TopK top(k);
+		top.push(std::span<const int>(a));
+		std::vector<int> smallest = top.result();
+
+		// move everything below the k-th value to the front, then as many
+		// copies of it as the result holds; the rest keeps the back
+		int kth = smallest.back();
+		size_t front = 0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i] < kth)
+			{
+				std::swap(a[i], a[front++]);
+			}
+		}
+		size_t copies = k - front;
+		for (size_t i = front; i < a.size() && copies > 0; i++)
+		{
+			if (a[i] == kth)
+			{
+				std::swap(a[i], a[front++]);
+				copies--;
+			}
+		}
+		std::copy(smallest.begin(), smallest.end(), a.begin());
+	}
+};
+
+#endif	//#ifndef HEAPSELECT
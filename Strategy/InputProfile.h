@@ -0,0 +1,77 @@
+#ifndef INPUTPROFILE
+#define INPUTPROFILE
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+/***********************************************************************
+ * Cheap statistics about an input array that Policy uses to pick a
+ * strategy. One pass over the data counts ascending neighbours and
+ * natural runs; the duplicate ratio is estimated from an evenly spaced
+ * sample.
+ ***********************************************************************/
+struct InputProfile
+{
+	size_t size = 0;
+	size_t runs = 0;				// maximal ascending or descending runs
+	double presortedness = 0.0;		// fraction of neighbours already in order
+	double duplicateRatio = 0.0;	// estimated fraction of repeated keys
+
+	static InputProfile of(const std::vector<int>& a, size_t sampleSize = 1024)
+	{
+		InputProfile profile;
+		profile.size = a.size();
+		if (a.size() < 2)
+		{
+			profile.runs = a.size();
+			profile.presortedness = 1.0;
+			return profile;
+		}
+
+		size_t ordered = 0;
+		size_t runs = 1;
+		int direction = 0;	// +1 ascending, -1 descending, 0 undecided
+		for (size_t i = 1; i < a.size(); i++)
+		{
+			int step = a[i - 1] < a[i] ? 1 : (a[i] < a[i - 1] ? -1 : 0);
+			if (step >= 0)
+			{
+				ordered++;
+			}
+			if (step != 0 && direction != 0 && step != direction)
+			{
+				runs++;
+				direction = 0;
+			}
+			else if (step != 0)
+			{
+				direction = step;
+			}
+		}
+		profile.runs = runs;
+		profile.presortedness = static_cast<double>(ordered) / (a.size() - 1);
+
+		std::vector<int> sample;
+		size_t stride = std::max<size_t>(1, a.size() / sampleSize);
+		for (size_t i = 0; i < a.size() && sample.size() < sampleSize; i += stride)
+		{
+			sample.push_back(a[i]);
+		}
+		std::sort(sample.begin(), sample.end());
+		size_t distinct = std::unique(sample.begin(), sample.end()) - sample.begin();
+		profile.duplicateRatio = 1.0 - static_cast<double>(distinct) / sample.size();
+
+		return profile;
+	}
+};
+
+inline std::ostream& operator<<(std::ostream& out, const InputProfile& profile)
+{
+	return out << "n=" << profile.size
+		<< " runs=" << profile.runs
+		<< " presortedness=" << profile.presortedness
+		<< " duplicates=" << profile.duplicateRatio;
+}
+
+#endif	//#ifndef INPUTPROFILE
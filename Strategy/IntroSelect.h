@@ -0,0 +1,116 @@
+#ifndef INTROSELECT
+#define INTROSELECT
+
+#include <algorithm>
+#include <span>
+#include <utility>
+#include "HeapSelect.h"
+#include "IntroSort.h"
+#include "SelectStrategy.h"
+
+class IntroSelect : public SelectStrategy
+{
+	/***********************************************************************
+	 * Quickselect with median-of-three pivots and a three-way partition,
+	 * so only the side containing k is processed further: O(n) expected.
+	 * If the partitions keep being unbalanced the remaining range is
+	 * finished with HeapSelect, which bounds the worst case.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "IntroSelect";
+	}
+
+	void nthElement(std::span<int> a, size_t k) override
+	{
+		if (k >= a.size())
+		{
+			return;
+		}
+
+		size_t lo = 0;
+		size_t hi = a.size();
+		int depthLimit = 2 * log2(a.size());
+		while (hi - lo > 1)
+		{
+			if (depthLimit-- == 0)
+			{
+				fallback.nthElement(a.subspan(lo, hi - lo), k - lo);
+				return;
+			}
+
+			size_t lt, gt;
+			partition(a, lo, hi, median3(a[lo], a[lo + (hi - lo) / 2], a[hi - 1]), lt, gt);
+			if (k < lt)
+			{
+				hi = lt;
+			}
+			else if (k >= gt)
+			{
+				lo = gt;
+			}
+			else
+			{
+				return;
+			}
+		}
+	}
+
+	void partialSort(std::span<int> a, size_t k) override
+	{
+		k = std::min(k, a.size());
+		if (k == 0)
+		{
+			return;
+		}
+		nthElement(a, k - 1);
+		sorter.performSort(a.first(k), scratch);
+	}
+
+private:
+	HeapSelect fallback;
+	IntroSort sorter;
+	ScratchArena scratch;
+
+	static int log2(size_t n)
+	{
+		int depth = 0;
+		while (n > 1)
+		{
+			n >>= 1;
+			depth++;
+		}
+		return depth;
+	}
+
+	static int median3(int x, int y, int z)
+	{
+		return std::max(std::min(x, y), std::min(std::max(x, y), z));
+	}
+
+	// afterwards a[lo..lt-1] < pivot, a[lt..gt-1] == pivot, a[gt..hi-1] > pivot
+	static void partition(std::span<int> a, size_t lo, size_t hi, int pivot, size_t& lt, size_t& gt)
+	{
+		lt = lo;
+		gt = hi;
+		size_t i = lo;
+		while (i < gt)
+		{
+			if (a[i] < pivot)
+			{
+				std::swap(a[lt++], a[i++]);
+			}
+			else if (pivot < a[i])
+			{
+				std::swap(a[i], a[--gt]);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+};
+
+#endif	//#ifndef INTROSELECT
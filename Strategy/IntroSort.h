@@ -0,0 +1,162 @@
+#ifndef INTROSORT
+#define INTROSORT
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <utility>
+#include <vector>
+#include "SortStrategy.h"
+#include "SortingNetwork.h"
+
+class IntroSort : public SortStrategy
+{
+	/***********************************************************************
+	 * Introspective quicksort.
+	 *
+	 * Pivots are the median of three (ninther for large ranges), the
+	 * partition is three-way so runs of equal keys are finished in one
+	 * step, small ranges go through a sorting network and a heapsort
+	 * takes over if the recursion gets deeper than 2*log2(n). Only the
+	 * smaller side is recursed into, so the stack depth stays O(log n).
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "IntroSort";
+	}
+
+	void performSort(std::vector<int>& a) override
+	{
+		sortRange(a);
+	}
+
+	void performSort(std::span<int> a, ScratchArena&) override
+	{
+		sortRange(a);
+	}
+
+private:
+	static constexpr int NETWORK_CUTOFF = SortingNetwork::MAX_BLOCK;
+	static constexpr int NINTHER_THRESHOLD = 128;
+
+	static void sortRange(std::span<int> a)
+	{
+		int n = a.size();
+		if (n > 1)
+		{
+			introsort(a, 0, n, 2 * log2(n));
+		}
+	}
+
+	static int log2(int n)
+	{
+		int depth = 0;
+		while (n > 1)
+		{
+			n >>= 1;
+			depth++;
+		}
+		return depth;
+	}
+
+	/***********************************************************************
+	 * Sort the subarray a[lo] .. a[hi-1].
+	 ***********************************************************************/
+	static void introsort(std::span<int> a, int lo, int hi, int depthLimit)
+	{
+		SORT_TRACE_DEPTH();
+		while (hi - lo > NETWORK_CUTOFF)
+		{
+			if (depthLimit-- == 0)
+			{
+				heapsort(a, lo, hi);
+				return;
+			}
+
+			int lt, gt;
+			partition(a, lo, hi, choosePivot(a, lo, hi), lt, gt);
+
+			// recurse into the smaller side, loop on the larger one
+			if (lt - lo < hi - gt)
+			{
+				introsort(a, lo, lt, depthLimit);
+				lo = gt;
+			}
+			else
+			{
+				introsort(a, gt, hi, depthLimit);
+				hi = lt;
+			}
+		}
+		SortingNetwork::sortSmall(a.data() + lo, hi - lo);
+	}
+
+	static int median3(std::span<int> a, int i, int j, int k)
+	{
+		SORT_COUNT_COMPARISONS(3);
+		if (a[i] < a[j])
+		{
+			return a[j] < a[k] ? j : (a[i] < a[k] ? k : i);
+		}
+		return a[i] < a[k] ? i : (a[j] < a[k] ? k : j);
+	}
+
+	static int choosePivot(std::span<int> a, int lo, int hi)
+	{
+		int n = hi - lo;
+		int mid = lo + n / 2;
+		if (n < NINTHER_THRESHOLD)
+		{
+			return a[median3(a, lo, mid, hi - 1)];
+		}
+
+		// Tukey's ninther: median of three medians of three
+		int s = n / 8;
+		int m1 = median3(a, lo, lo + s, lo + 2 * s);
+		int m2 = median3(a, mid - s, mid, mid + s);
+		int m3 = median3(a, hi - 1 - 2 * s, hi - 1 - s, hi - 1);
+		return a[median3(a, m1, m2, m3)];
+	}
+
+	/***********************************************************************
+	 * Dijkstra's three-way partition. Afterwards a[lo..lt-1] < pivot,
+	 * a[lt..gt-1] == pivot and a[gt..hi-1] > pivot.
+	 ***********************************************************************/
+	static void partition(std::span<int> a, int lo, int hi, int pivot, int& lt, int& gt)
+	{
+		lt = lo;
+		gt = hi;
+		int i = lo;
+		while (i < gt)
+		{
+			SORT_COUNT_COMPARISONS(a[i] < pivot ? 1 : 2);
+			if (a[i] < pivot)
+			{
+				SORT_COUNT_MOVES(2);
+				std::swap(a[lt++], a[i++]);
+			}
+			else if (pivot < a[i])
+			{
+				SORT_COUNT_MOVES(2);
+				std::swap(a[i], a[--gt]);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	// counted as the 2 n log2 n comparisons and moves of a heapsort
+	static void heapsort(std::span<int> a, int lo, int hi)
+	{
+		SORT_COUNT_COMPARISONS(uint64_t(2 * (hi - lo) * std::log2(hi - lo)));
+		SORT_COUNT_MOVES(uint64_t(2 * (hi - lo) * std::log2(hi - lo)));
+		std::make_heap(a.begin() + lo, a.begin() + hi);
+		std::sort_heap(a.begin() + lo, a.begin() + hi);
+	}
+};
+
+
+#endif	//#ifndef INTROSORT
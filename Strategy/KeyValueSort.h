@@ -0,0 +1,129 @@
+#ifndef KEYVALUESORT
+#define KEYVALUESORT
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+#include "RadixSort.h"
+
+/***********************************************************************
+ * Sorts a column of int keys and permutes a payload column alongside it.
+ *
+ * Keys and payloads stay in separate arrays (structure of arrays), so
+ * the key passes only stream through keys and no (key, value) pairs are
+ * ever built. It is an LSD radix sort with the same digits as RadixSort
+ * and therefore stable: equal keys keep their payload order.
+ *
+ * The scratch columns are kept between calls. Payloads are moved into
+ * the raw scratch storage on the first pass that runs and destroyed
+ * again at the end, so they need no default constructor, but their moves
+ * must not throw.
+ ***********************************************************************/
+class KeyValueSort
+{
+public:
+	template <typename Payload>
+	void sortByKey(std::span<int> keys, std::span<Payload> values)
+	{
+		static_assert(alignof(Payload) <= alignof(std::max_align_t), "over-aligned payloads are not supported");
+		static_assert(std::is_nothrow_move_constructible_v<Payload> && std::is_nothrow_move_assignable_v<Payload>,
+			"payload moves must not throw");
+
+		size_t n = keys.size();
+		if (n < 2)
+		{
+			return;
+		}
+
+		if (keyScratch.size() < n)
+		{
+			keyScratch.resize(n);
+		}
+		size_t valueWords = (n * sizeof(Payload) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		if (valueScratch.size() < valueWords)
+		{
+			valueScratch.resize(valueWords);
+		}
+		Payload* scratchValues = reinterpret_cast<Payload*>(valueScratch.data());
+		bool scratchConstructed = false;
+
+		size_t count[RadixSort::DIGITS][RadixSort::BUCKETS] = {};
+		for (size_t i = 0; i < n; i++)
+		{
+			uint32_t key = static_cast<uint32_t>(keys[i]);
+			for (int d = 0; d < RadixSort::DIGITS; d++)
+			{
+				count[d][RadixSort::digit(key, d)]++;
+			}
+		}
+
+		int* srcKeys = keys.data();
+		int* dstKeys = keyScratch.data();
+		Payload* srcValues = values.data();
+		Payload* dstValues = scratchValues;
+		for (int d = 0; d < RadixSort::DIGITS; d++)
+		{
+			if (count[d][RadixSort::digit(static_cast<uint32_t>(srcKeys[0]), d)] == n)
+			{
+				continue;
+			}
+
+			size_t offset[RadixSort::BUCKETS];
+			size_t sum = 0;
+			for (int b = 0; b < RadixSort::BUCKETS; b++)
+			{
+				offset[b] = sum;
+				sum += count[d][b];
+			}
+
+			for (size_t i = 0; i < n; i++)
+			{
+				size_t target = offset[RadixSort::digit(static_cast<uint32_t>(srcKeys[i]), d)]++;
+				dstKeys[target] = srcKeys[i];
+				if (scratchConstructed)
+				{
+					dstValues[target] = std::move(srcValues[i]);
+				}
+				else
+				{
+					::new (static_cast<void*>(dstValues + target)) Payload(std::move(srcValues[i]));
+				}
+			}
+			scratchConstructed = true;
+			std::swap(srcKeys, dstKeys);
+			std::swap(srcValues, dstValues);
+		}
+
+		if (srcKeys != keys.data())
+		{
+			std::copy(srcKeys, srcKeys + n, keys.data());
+			std::move(srcValues, srcValues + n, values.data());
+		}
+		if (scratchConstructed)
+		{
+			std::destroy_n(scratchValues, n);
+		}
+	}
+
+	// Returns the permutation that sorts keys, leaving keys untouched.
+	std::vector<uint32_t> argsort(std::span<const int> keys)
+	{
+		std::vector<int> sortedKeys(keys.begin(), keys.end());
+		std::vector<uint32_t> order(keys.size());
+		std::iota(order.begin(), order.end(), 0u);
+		sortByKey(std::span<int>(sortedKeys), std::span<uint32_t>(order));
+		return order;
+	}
+
+private:
+	std::vector<int> keyScratch;
+	std::vector<std::max_align_t> valueScratch;	// raw storage for any payload type
+};
+
+#endif	//#ifndef KEYVALUESORT
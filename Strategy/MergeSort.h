@@ -1,8 +1,12 @@
 #ifndef MERGESORT
 #define MERGESORT
 
+#include <algorithm>
+#include <span>
+#include <utility>
 #include <vector>
 #include "SortStrategy.h"
+#include "SortingNetwork.h"
 
 class MergeSort : public SortStrategy
 {
@@ -12,12 +16,97 @@ class MergeSort : public SortStrategy
 	 * Sort the array a using mergesort
 	 ***********************************************************************/
 public:
+	enum class Mode
+	{
+		TopDown,	// recursive, merges into aux[] and copies back
+		BottomUp	// iterative, alternates between a[] and aux[]
+	};
+
+	MergeSort(Mode mode = Mode::TopDown) : mode(mode)
+	{
+	}
+
+	const char* getName() const override
+	{
+		return mode == Mode::BottomUp ? "MergeSort (bottom-up)" : "MergeSort";
+	}
+
 	void performSort(std::vector<int>& a) override
 	{
 		int n = a.size();
 		std::vector<int> aux(n);
-		sort(a, aux, 0, n);
+		SORT_COUNT_SCRATCH(n * sizeof(int));
+		if (mode == Mode::BottomUp)
+		{
+			bottomUpSort(a.data(), aux.data(), n);
+		}
+		else
+		{
+			sort(a, aux, 0, n);
+		}
 	}
+
+	void performSort(std::vector<int>& a, ScratchArena& scratch) override
+	{
+		if (mode != Mode::BottomUp)
+		{
+			performSort(a);
+			return;
+		}
+		int n = a.size();
+		bottomUpSort(a.data(), scratch.acquire(n), n);
+	}
+
+	void performSort(std::span<int> a, ScratchArena& scratch) override
+	{
+		if (mode != Mode::BottomUp)
+		{
+			SortStrategy::performSort(a, scratch);
+			return;
+		}
+		int n = a.size();
+		bottomUpSort(a.data(), scratch.acquire(n), n);
+	}
+
+private:
+	static constexpr int RUN_LENGTH = SortingNetwork::MAX_BLOCK;
+
+	Mode mode;
+
+protected:
+	/***********************************************************************
+	 * Bottom-up mergesort of a[0] .. a[n-1]. Each level merges runs from
+	 * one buffer into the other, so nothing is copied back between levels;
+	 * only an odd number of levels needs a final copy into a[].
+	 ***********************************************************************/
+	static void bottomUpSort(int* a, int* aux, int n)
+	{
+		// sort short runs with the sorting network first
+		for (int lo = 0; lo < n; lo += RUN_LENGTH)
+		{
+			SortingNetwork::sortSmall(a + lo, std::min(RUN_LENGTH, n - lo));
+		}
+
+		int* src = a;
+		int* dst = aux;
+		for (int width = RUN_LENGTH; width < n; width *= 2)
+		{
+			for (int lo = 0; lo < n; lo += 2 * width)
+			{
+				int mid = std::min(lo + width, n);
+				int hi = std::min(lo + 2 * width, n);
+				SortingNetwork::merge(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != a)
+		{
+			SORT_COUNT_MOVES(n);
+			std::copy(src, src + n, a);
+		}
+	}
+
 	/***********************************************************************
 	 * Merge the subarrays a[lo] .. a[mid-1] and a[mid] .. a[hi-1] into a[lo] ..
 	 * a[hi-1] using the auxilliary array aux[] as scratch space.
@@ -26,31 +115,13 @@ public:
 	 * a[lo] .. a[hi-1] is in ascending order
 	 *
 	 ***********************************************************************/
-private:
+protected:
 	static void merge(std::vector<int>& a, std::vector<int>& aux, int lo, int mid, int hi)
 	{
-		int i = lo, j = mid;
-		for (int k = lo; k < hi; k++)
-		{
-			if (i == mid)
-			{
-				aux[k] = a[j++];
-			}
-			else if (j == hi)
-			{
-				aux[k] = a[i++];
-			}
-			else if (a[j] < a[i])
-			{
-				aux[k] = a[j++];
-			}
-			else
-			{
-				aux[k] = a[i++];
-			}
-		}
+		SortingNetwork::merge(&a[lo], mid - lo, &a[mid], hi - mid, &aux[lo]);
 
 		// copy back
+		SORT_COUNT_MOVES(hi - lo);
 		for (int k = lo; k < hi; k++)
 		{
 			a[k] = aux[k];
@@ -63,10 +134,12 @@ private:
 	 ***********************************************************************/
 	static void sort(std::vector<int>& a, std::vector<int>& aux, int lo, int hi)
 	{
+		SORT_TRACE_DEPTH();
 
-		// base case
-		if (hi - lo <= 1)
+		// base case: small ranges go through a sorting network
+		if (hi - lo <= SortingNetwork::MAX_BLOCK)
 		{
+			SortingNetwork::sortSmall(a.data() + lo, hi - lo);
 			return;
 		}
 
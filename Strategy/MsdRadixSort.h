@@ -0,0 +1,125 @@
+#ifndef MSDRADIXSORT
+#define MSDRADIXSORT
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "MultikeyQuickSort.h"
+#include "StringSortStrategy.h"
+
+class MsdRadixSort : public StringSortStrategy
+{
+	/***********************************************************************
+	 * Most significant digit first radix sort on string characters.
+	 *
+	 * Each step distributes a range into 257 buckets by the character at
+	 * the current depth (bucket 0 holds the strings that end there) and
+	 * queues every bucket to be sorted one character deeper. Buckets wait
+	 * on an explicit work stack rather than in recursive calls, so long
+	 * shared prefixes cost heap memory instead of stack. The characters are
+	 * read once into a small array before counting and scattering, so the
+	 * pool is touched only once per string and level. A step that leaves
+	 * everything in one bucket just moves to the next character. Buckets
+	 * below the cutoff are too small to pay for the counting and are
+	 * finished with multikey quicksort.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "MsdRadixSort";
+	}
+
+	void performSort(StringPool& pool) override
+	{
+		std::vector<StringPool::Ref>& refs = pool.getRefs();
+
+		// scratch is kept between calls and only ever grows
+		if (scratch.size() < refs.size())
+		{
+			scratch.resize(refs.size());
+			characters.resize(refs.size());
+		}
+		work.push_back({0, refs.size(), 0});
+		while (!work.empty())
+		{
+			Bucket bucket = work.back();
+			work.pop_back();
+			msdSort(pool, std::span<StringPool::Ref>(refs).subspan(bucket.base, bucket.size), bucket.base, bucket.depth);
+		}
+	}
+
+private:
+	static constexpr size_t BUCKET_CUTOFF = 64;
+	static constexpr int BUCKETS = 257;
+
+	// a range of the pool's references still to be sorted from depth on
+	struct Bucket
+	{
+		size_t base;
+		size_t size;
+		size_t depth;
+	};
+
+	std::vector<StringPool::Ref> scratch;
+	std::vector<uint16_t> characters;
+	// pending buckets are disjoint and hold two or more strings each, so
+	// there are never more than half as many as strings
+	std::vector<Bucket> work;
+
+	// Sorts refs, which starts at position base of the pool's references,
+	// or distributes it and queues its buckets
+	void msdSort(const StringPool& pool, std::span<StringPool::Ref> refs, size_t base, size_t depth)
+	{
+		size_t n = refs.size();
+		while (n >= BUCKET_CUTOFF)
+		{
+			uint16_t* keys = characters.data() + base;
+			size_t count[BUCKETS + 1] = {};
+			for (size_t i = 0; i < n; i++)
+			{
+				keys[i] = static_cast<uint16_t>(pool.charAt(refs[i], depth) + 1);
+				count[keys[i] + 1]++;
+			}
+
+			// all strings share this character: nothing to distribute
+			if (count[keys[0] + 1] == n)
+			{
+				if (keys[0] == 0)
+				{
+					return;		// and they all end here
+				}
+				depth++;
+				continue;
+			}
+
+			for (int b = 0; b < BUCKETS; b++)
+			{
+				count[b + 1] += count[b];
+			}
+			StringPool::Ref* out = scratch.data() + base;
+			size_t next[BUCKETS];
+			std::copy(count, count + BUCKETS, next);
+			for (size_t i = 0; i < n; i++)
+			{
+				out[next[keys[i]]++] = refs[i];
+			}
+			std::copy(out, out + n, refs.begin());
+
+			// bucket 0 holds complete, equal strings
+			for (int b = 1; b < BUCKETS; b++)
+			{
+				size_t size = count[b + 1] - count[b];
+				if (size > 1)
+				{
+					work.push_back({base + count[b], size, depth + 1});
+				}
+			}
+			return;
+		}
+		MultikeyQuickSort::sortRange(pool, refs, depth);
+	}
+};
+
+
+#endif	//#ifndef MSDRADIXSORT
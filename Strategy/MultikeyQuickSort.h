@@ -0,0 +1,132 @@
+#ifndef MULTIKEYQUICKSORT
+#define MULTIKEYQUICKSORT
+
+#include <span>
+#include <string_view>
+#include <utility>
+#include "StringSortStrategy.h"
+
+class MultikeyQuickSort : public StringSortStrategy
+{
+	/***********************************************************************
+	 * Bentley and Sedgewick's multikey quicksort.
+	 *
+	 * Partitions three ways on one character at a time: strings whose
+	 * character at the current depth is smaller or larger than the pivot
+	 * character are sorted recursively at the same depth, the equal ones
+	 * move on to the next character. Common prefixes are therefore read
+	 * once per partitioning step instead of once per comparison. Works in
+	 * place on the references; small ranges use insertion sort on the
+	 * remaining suffixes. Only the two smaller of the three partitions are
+	 * sorted recursively and the largest one in the loop, so the stack
+	 * stays O(log n) deep.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "MultikeyQuickSort";
+	}
+
+	void performSort(StringPool& pool) override
+	{
+		sortRange(pool, pool.getRefs(), 0);
+	}
+
+	// sorts refs, all of which share their first depth characters
+	static void sortRange(const StringPool& pool, std::span<StringPool::Ref> refs, size_t depth)
+	{
+		while (refs.size() > INSERTION_CUTOFF)
+		{
+			int pivot = pool.charAt(refs[medianOf3(pool, refs, depth)], depth);
+
+			// a[0..lt) < pivot, a[lt..gt) == pivot, a[gt..n) > pivot
+			size_t lt = 0;
+			size_t gt = refs.size();
+			size_t i = 0;
+			while (i < gt)
+			{
+				int c = pool.charAt(refs[i], depth);
+				if (c < pivot)
+				{
+					std::swap(refs[lt++], refs[i++]);
+				}
+				else if (c > pivot)
+				{
+					std::swap(refs[i], refs[--gt]);
+				}
+				else
+				{
+					i++;
+				}
+			}
+
+			// strings that ended at this depth are equal and done
+			std::pair<std::span<StringPool::Ref>, size_t> parts[3] = {
+				{refs.first(lt), depth},
+				{pivot < 0 ? std::span<StringPool::Ref>() : refs.subspan(lt, gt - lt), depth + 1},
+				{refs.subspan(gt), depth},
+			};
+			int largest = 0;
+			for (int p = 1; p < 3; p++)
+			{
+				if (parts[p].first.size() > parts[largest].first.size())
+				{
+					largest = p;
+				}
+			}
+			for (int p = 0; p < 3; p++)
+			{
+				if (p != largest)
+				{
+					sortRange(pool, parts[p].first, parts[p].second);
+				}
+			}
+			refs = parts[largest].first;
+			depth = parts[largest].second;
+		}
+		insertionSort(pool, refs, depth);
+	}
+
+private:
+	static constexpr size_t INSERTION_CUTOFF = 16;
+
+	static size_t medianOf3(const StringPool& pool, std::span<StringPool::Ref> refs, size_t depth)
+	{
+		size_t i = 0;
+		size_t j = refs.size() / 2;
+		size_t k = refs.size() - 1;
+		int a = pool.charAt(refs[i], depth);
+		int b = pool.charAt(refs[j], depth);
+		int c = pool.charAt(refs[k], depth);
+		if (a < b)
+		{
+			return b < c ? j : (a < c ? k : i);
+		}
+		return a < c ? i : (b < c ? k : j);
+	}
+
+	static void insertionSort(const StringPool& pool, std::span<StringPool::Ref> refs, size_t depth)
+	{
+		for (size_t i = 1; i < refs.size(); i++)
+		{
+			StringPool::Ref value = refs[i];
+			std::string_view key = suffix(pool, value, depth);
+			size_t j = i;
+			while (j > 0 && key < suffix(pool, refs[j - 1], depth))
+			{
+				refs[j] = refs[j - 1];
+				j--;
+			}
+			refs[j] = value;
+		}
+	}
+
+	static std::string_view suffix(const StringPool& pool, StringPool::Ref ref, size_t depth)
+	{
+		std::string_view s = pool.view(ref);
+		return depth < s.size() ? s.substr(depth) : std::string_view();
+	}
+};
+
+
+#endif	//#ifndef MULTIKEYQUICKSORT
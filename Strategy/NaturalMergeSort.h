@@ -0,0 +1,287 @@
+#ifndef NATURALMERGESORT
+#define NATURALMERGESORT
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+#include "SortStrategy.h"
+
+class NaturalMergeSort : public SortStrategy
+{
+	/***********************************************************************
+	 * Run-adaptive mergesort in the style of TimSort.
+	 *
+	 * The array is scanned for natural runs (descending runs are reversed),
+	 * short runs are extended to a minimum length with binary insertion
+	 * sort, and the runs are merged from a stack that keeps the merges
+	 * balanced. Merges gallop when one side keeps winning, so long
+	 * presorted stretches are copied in bulk. Already sorted input costs a
+	 * single pass.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "NaturalMergeSort";
+	}
+
+	void performSort(std::vector<int>& a) override
+	{
+		std::vector<int> tmp(a.size());
+		SORT_COUNT_SCRATCH(a.size() * sizeof(int));
+		naturalSort(a.data(), static_cast<int>(a.size()), tmp.data());
+	}
+
+	void performSort(std::vector<int>& a, ScratchArena& scratch) override
+	{
+		naturalSort(a.data(), static_cast<int>(a.size()), scratch.acquire(a.size()));
+	}
+
+	void performSort(std::span<int> a, ScratchArena& scratch) override
+	{
+		naturalSort(a.data(), static_cast<int>(a.size()), scratch.acquire(a.size()));
+	}
+
+private:
+	static constexpr int MIN_MERGE = 32;
+	static constexpr int MIN_GALLOP = 7;
+
+	struct Run
+	{
+		int base;
+		int length;
+	};
+
+	static void naturalSort(int* a, int n, int* tmp)
+	{
+		if (n < 2)
+		{
+			return;
+		}
+
+		std::vector<Run> runs;
+		int minRun = minRunLength(n);
+		int lo = 0;
+		while (lo < n)
+		{
+			int length = countRunAndMakeAscending(a, lo, n);
+			if (length < minRun)
+			{
+				int forced = std::min(minRun, n - lo);
+				binaryInsertionSort(a, lo, lo + forced, lo + length);
+				length = forced;
+			}
+			runs.push_back({lo, length});
+			mergeCollapse(a, tmp, runs);
+			lo += length;
+		}
+		mergeForceCollapse(a, tmp, runs);
+	}
+
+	static int minRunLength(int n)
+	{
+		int r = 0;
+		while (n >= MIN_MERGE)
+		{
+			r |= n & 1;
+			n >>= 1;
+		}
+		return n + r;
+	}
+
+	/***********************************************************************
+	 * Returns the length of the run starting at a[lo]. A strictly
+	 * descending run is reversed in place, so every run is ascending.
+	 ***********************************************************************/
+	static int countRunAndMakeAscending(int* a, int lo, int hi)
+	{
+		int r = lo + 1;
+		if (r == hi)
+		{
+			return 1;
+		}
+		if (a[r] < a[lo])
+		{
+			while (r + 1 < hi && a[r + 1] < a[r])
+			{
+				r++;
+			}
+			std::reverse(a + lo, a + r + 1);
+			SORT_COUNT_MOVES(r + 1 - lo);
+		}
+		else
+		{
+			while (r + 1 < hi && !(a[r + 1] < a[r]))
+			{
+				r++;
+			}
+		}
+		SORT_COUNT_COMPARISONS(r + 1 - lo);
+		return r + 1 - lo;
+	}
+
+	// sort a[lo] .. a[hi-1], given that a[lo] .. a[start-1] is sorted
+	static void binaryInsertionSort(int* a, int lo, int hi, int start)
+	{
+		for (int i = start; i < hi; i++)
+		{
+			int value = a[i];
+			int* position = std::upper_bound(a + lo, a + i, value);
+			SORT_COUNT_COMPARISONS(std::log2(i - lo + 1) + 1);
+			SORT_COUNT_MOVES(a + i - position + 1);
+			std::copy_backward(position, a + i, a + i + 1);
+			*position = value;
+		}
+	}
+
+	/***********************************************************************
+	 * Keep the run lengths on the stack growing at least like Fibonacci
+	 * numbers from the top down, which bounds the stack to O(log n) runs
+	 * and keeps every merge reasonably balanced.
+	 ***********************************************************************/
+	static void mergeCollapse(int* a, int* tmp, std::vector<Run>& runs)
+	{
+		while (runs.size() > 1)
+		{
+			int n = static_cast<int>(runs.size()) - 2;
+			if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length)
+				|| (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length))
+			{
+				if (runs[n - 1].length < runs[n + 1].length)
+				{
+					n--;
+				}
+			}
+			else if (runs[n].length > runs[n + 1].length)
+			{
+				break;
+			}
+			mergeAt(a, tmp, runs, n);
+		}
+	}
+
+	static void mergeForceCollapse(int* a, int* tmp, std::vector<Run>& runs)
+	{
+		while (runs.size() > 1)
+		{
+			int n = static_cast<int>(runs.size()) - 2;
+			if (n > 0 && runs[n - 1].length < runs[n + 1].length)
+			{
+				n--;
+			}
+			mergeAt(a, tmp, runs, n);
+		}
+	}
+
+	static void mergeAt(int* a, int* tmp, std::vector<Run>& runs, int i)
+	{
+		int lo = runs[i].base;
+		int mid = lo + runs[i].length;
+		int hi = mid + runs[i + 1].length;
+		runs[i].length += runs[i + 1].length;
+		runs.erase(runs.begin() + i + 1);
+		merge(a, tmp, lo, mid, hi);
+	}
+
+	/***********************************************************************
+	 * Number of leading elements of base[0] .. base[length-1] that go
+	 * before key: those <= key if upper is set, those < key otherwise.
+	 * Probes 1, 3, 7, ... first, so short answers are found quickly.
+	 ***********************************************************************/
+	static int gallop(int key, const int* base, int length, bool upper)
+	{
+		auto before = [key, upper](int x)
+		{
+			SORT_COUNT_COMPARISONS(1);
+			return upper ? !(key < x) : x < key;
+		};
+		if (length == 0 || !before(base[0]))
+		{
+			return 0;
+		}
+		int lo = 0;
+		int hi = 1;
+		while (hi < length && before(base[hi]))
+		{
+			lo = hi;
+			hi = 2 * hi + 1;
+		}
+		hi = std::min(hi, length);
+		SORT_COUNT_COMPARISONS(std::log2(hi - lo) + 1);
+		const int* end = upper ? std::upper_bound(base + lo + 1, base + hi, key)
+			: std::lower_bound(base + lo + 1, base + hi, key);
+		return static_cast<int>(end - base);
+	}
+
+	/***********************************************************************
+	 * Merge the ascending runs a[lo] .. a[mid-1] and a[mid] .. a[hi-1].
+	 * Only the part of the left run that actually overlaps the right run
+	 * is moved to tmp[]; the merge then switches between one-at-a-time
+	 * and galloping mode.
+	 ***********************************************************************/
+	static void merge(int* a, int* tmp, int lo, int mid, int hi)
+	{
+		// a[lo] .. of the left run that is <= a[mid] is already in place
+		lo += gallop(a[mid], a + lo, mid - lo, true);
+		if (lo == mid)
+		{
+			return;
+		}
+		// so is the tail of the right run that is >= a[mid-1]
+		hi = mid + gallop(a[mid - 1], a + mid, hi - mid, false);
+
+		int lengthA = mid - lo;
+		SORT_COUNT_MOVES(lengthA + hi - lo);
+		std::copy(a + lo, a + mid, tmp);
+
+		int i = 0;
+		int j = mid;
+		int d = lo;
+		while (i < lengthA && j < hi)
+		{
+			int winsA = 0;
+			int winsB = 0;
+			while (i < lengthA && j < hi && winsA < MIN_GALLOP && winsB < MIN_GALLOP)
+			{
+				SORT_COUNT_COMPARISONS(1);
+				if (a[j] < tmp[i])
+				{
+					a[d++] = a[j++];
+					winsB++;
+					winsA = 0;
+				}
+				else
+				{
+					a[d++] = tmp[i++];
+					winsA++;
+					winsB = 0;
+				}
+			}
+
+			// galloping mode: copy whole stretches while they stay long
+			while (i < lengthA && j < hi)
+			{
+				winsA = gallop(a[j], tmp + i, lengthA - i, true);
+				d = static_cast<int>(std::copy(tmp + i, tmp + i + winsA, a + d) - a);
+				i += winsA;
+				if (i == lengthA)
+				{
+					break;
+				}
+
+				winsB = gallop(tmp[i], a + j, hi - j, false);
+				d = static_cast<int>(std::copy(a + j, a + j + winsB, a + d) - a);
+				j += winsB;
+
+				if (winsA < MIN_GALLOP && winsB < MIN_GALLOP)
+				{
+					break;
+				}
+			}
+		}
+		std::copy(tmp + i, tmp + lengthA, a + d);
+	}
+};
+
+
+#endif	//#ifndef NATURALMERGESORT
@@ -0,0 +1,136 @@
+#ifndef NUMATOPOLOGY
+#define NUMATOPOLOGY
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************************
+ * Which CPUs belong to which NUMA node, read from sysfs on Linux.
+ *
+ * nodeOf() asks the kernel which node holds the page of an address
+ * (move_pages without target nodes only queries). Without NUMA support
+ * the machine is reported as a single node that owns every CPU, and
+ * pinning does nothing.
+ ***********************************************************************/
+class NumaTopology
+{
+public:
+	static const NumaTopology& get()
+	{
+		static const NumaTopology topology;
+		return topology;
+	}
+
+	int getNodeCount() const
+	{
+		return static_cast<int>(nodes.size());
+	}
+
+	const std::vector<int>& getCpus(int node) const
+	{
+		return nodes[node];
+	}
+
+	// node that holds the memory at address, 0 if it cannot be determined
+	int nodeOf(const void* address) const
+	{
+#if defined(__linux__) && defined(SYS_move_pages)
+		if (nodes.size() > 1)
+		{
+			long pageSize = sysconf(_SC_PAGESIZE);
+			void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~(uintptr_t(pageSize) - 1));
+			int status = -1;
+			if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) == 0
+				&& status >= 0 && status < static_cast<int>(nodes.size()))
+			{
+				return status;
+			}
+		}
+#endif
+		return 0;
+	}
+
+	// restricts the calling thread to the CPUs of node
+	void pinCurrentThread(int node) const
+	{
+#ifdef __linux__
+		if (nodes.size() < 2 || nodes[node].empty())
+		{
+			return;
+		}
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : nodes[node])
+		{
+			CPU_SET(cpu, &set);
+		}
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+		(void)node;
+#endif
+	}
+
+private:
+	std::vector<std::vector<int>> nodes;
+
+	NumaTopology()
+	{
+#ifdef __linux__
+		for (int node = 0;; node++)
+		{
+			std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+			if (!cpulist)
+			{
+				break;
+			}
+			std::string line;
+			std::getline(cpulist, line);
+			nodes.push_back(parseCpuList(line));
+		}
+#endif
+		if (nodes.empty())
+		{
+			nodes.emplace_back();
+			for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++)
+			{
+				nodes.back().push_back(cpu);
+			}
+		}
+	}
+
+	// parses lists such as "0-3,8-11"
+	static std::vector<int> parseCpuList(const std::string& list)
+	{
+		std::vector<int> cpus;
+		std::stringstream ranges(list);
+		std::string range;
+		while (std::getline(ranges, range, ','))
+		{
+			if (range.empty())
+			{
+				continue;
+			}
+			size_t dash = range.find('-');
+			int first = std::stoi(range.substr(0, dash));
+			int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+			for (int cpu = first; cpu <= last; cpu++)
+			{
+				cpus.push_back(cpu);
+			}
+		}
+		return cpus;
+	}
+};
+
+#endif	//#ifndef NUMATOPOLOGY
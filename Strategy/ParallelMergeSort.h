@@ -0,0 +1,175 @@
+#ifndef PARALLELMERGESORT
+#define PARALLELMERGESORT
+
+#include <algorithm>
+#include <span>
+#include <vector>
+#include "MergeSort.h"
+#include "TaskPool.h"
+
+class ParallelMergeSort : public MergeSort
+{
+	/***********************************************************************
+	 * Fork-join mergesort on a work-stealing TaskPool. Ranges at or below
+	 * the grain size are handed to the serial MergeSort, larger merges are
+	 * split into independent segments by co-ranking.
+	 ***********************************************************************/
+public:
+	explicit ParallelMergeSort(unsigned threads, int grainSize = 1 << 14)
+		: pool(threads), grainSize(grainSize)
+	{
+	}
+
+	void setGrainSize(int size)
+	{
+		grainSize = std::max(size, 2);
+	}
+
+	int getGrainSize() const
+	{
+		return grainSize;
+	}
+
+	const char* getName() const override
+	{
+		return "ParallelMergeSort";
+	}
+
+	void performSort(std::vector<int>& a) override
+	{
+		int n = a.size();
+		std::vector<int> aux(n);
+		SORT_COUNT_SCRATCH(n * sizeof(int));
+		sortWith(a.data(), aux.data(), n);
+	}
+
+	void performSort(std::vector<int>& a, ScratchArena& scratch) override
+	{
+		int n = a.size();
+		sortWith(a.data(), scratch.acquire(n), n);
+	}
+
+	void performSort(std::span<int> a, ScratchArena& scratch) override
+	{
+		int n = a.size();
+		sortWith(a.data(), scratch.acquire(n), n);
+	}
+
+private:
+	TaskPool pool;
+	int grainSize;
+
+	/***********************************************************************
+	 * Returns how many of the first k merged elements of A[0..m) and
+	 * B[0..n) come from A. Ties are taken from A first, which keeps the
+	 * merge stable.
+	 ***********************************************************************/
+	static int corank(int k, const int* A, int m, const int* B, int n)
+	{
+		int lo = std::max(0, k - n);
+		int hi = std::min(k, m);
+		while (true)
+		{
+			int i = lo + (hi - lo) / 2;
+			int j = k - i;
+			if (i < m && j > 0 && B[j - 1] >= A[i])
+			{
+				lo = i + 1;
+			}
+			else if (i > 0 && j < n && A[i - 1] > B[j])
+			{
+				hi = i - 1;
+			}
+			else
+			{
+				return i;
+			}
+		}
+	}
+
+	/***********************************************************************
+	 * Merge src[lo] .. src[mid-1] and src[mid] .. src[hi-1] into dst[lo] ..
+	 * dst[hi-1]. The output is cut into segments of about one grain each;
+	 * every segment locates its inputs with corank() and merges
+	 * independently.
+	 ***********************************************************************/
+	void parallelMerge(const int* src, int* dst, int lo, int mid, int hi)
+	{
+		const int* A = src + lo;
+		const int* B = src + mid;
+		int m = mid - lo;
+		int n = hi - mid;
+		int total = m + n;
+		int segments = std::min<int>((total + grainSize - 1) / grainSize, 4 * pool.size());
+
+		TaskPool::TaskGroup group;
+		for (int s = 0; s < segments; s++)
+		{
+			int kBegin = static_cast<int>(static_cast<long long>(total) * s / segments);
+			int kEnd = static_cast<int>(static_cast<long long>(total) * (s + 1) / segments);
+			auto task = [&, kBegin, kEnd]
+			{
+				int iBegin = corank(kBegin, A, m, B, n);
+				int iEnd = corank(kEnd, A, m, B, n);
+				int jBegin = kBegin - iBegin;
+				int jEnd = kEnd - iEnd;
+				SortingNetwork::merge(A + iBegin, iEnd - iBegin, B + jBegin, jEnd - jBegin, dst + lo + kBegin);
+			};
+			runSegment(group, s + 1 == segments, task);
+		}
+		pool.wait(group);
+	}
+
+	template <typename Task>
+	void runSegment(TaskPool::TaskGroup& group, bool last, Task& task)
+	{
+		if (last)
+		{
+			task();
+		}
+		else
+		{
+			pool.spawn(group, task);
+		}
+	}
+
+	/***********************************************************************
+	 * Copies a[] into aux[] once, then sorts with the buffers swapping
+	 * roles at every level, so no level copies back.
+	 ***********************************************************************/
+	void sortWith(int* a, int* aux, int n)
+	{
+		SORT_COUNT_MOVES(n);
+		std::copy(a, a + n, aux);
+		TaskPool::TaskGroup group;
+		pool.spawn(group, [&] { parallelSort(aux, a, 0, n); });
+		pool.wait(group);
+	}
+
+	/***********************************************************************
+	 * Sort dst[lo] .. dst[hi-1], which on entry holds the same elements as
+	 * src[lo] .. src[hi-1]; src[] is used as scratch space. The halves are
+	 * sorted into src[] and merged back into dst[].
+	 ***********************************************************************/
+	void parallelSort(int* src, int* dst, int lo, int hi)
+	{
+		SORT_TRACE_DEPTH();
+		if (hi - lo <= grainSize)
+		{
+			bottomUpSort(dst + lo, src + lo, hi - lo);
+			return;
+		}
+
+		// fork the left half, sort the right half on this thread
+		int mid = lo + (hi - lo) / 2;
+		TaskPool::TaskGroup group;
+		pool.spawn(group, [=, this] { parallelSort(dst, src, lo, mid); });
+		parallelSort(dst, src, mid, hi);
+		pool.wait(group);
+
+		parallelMerge(src, dst, lo, mid, hi);
+	}
+};
+
+
+#endif	//#ifndef PARALLELMERGESORT
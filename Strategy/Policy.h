@@ -1,29 +1,338 @@
 #ifndef POLICY
 #define POLICY
 
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string_view>
 #include "MergeSort.h"
-#include "QuickSort.h"
+#include "ParallelMergeSort.h"
+#include "IntroSort.h"
+#include "NaturalMergeSort.h"
+#include "InputProfile.h"
+#include "ExternalSort.h"
+#include "HeapSelect.h"
+#include "IntroSelect.h"
+#include "RadixSort.h"
+#include "SampleSort.h"
+#include "NumaTopology.h"
+#include "SortHistory.h"
+#include "MsdRadixSort.h"
+#include "MultikeyQuickSort.h"
 #include "Context.h"
+#include "StringContext.h"
 
 class Policy
 {
 	// TODO 4: declare the missing attribute (hint: check the constructor)
 private:
-	Context* context;	
+	Context* context;
+
+	// the policy owns its strategies, so reconfiguring does not leak them
+	MergeSort mergeSort{MergeSort::Mode::BottomUp};
+	IntroSort introSort;
+	NaturalMergeSort naturalMergeSort;
+	RadixSort radixSort;
+	std::unique_ptr<ParallelMergeSort> parallelMergeSort;
+	std::unique_ptr<SampleSort> sampleSort;
+	bool radixSortEnabled = false;
+
+	// string keys are sorted through their own context
+	StringContext* stringContext = nullptr;
+	MsdRadixSort msdRadixSort;
+	MultikeyQuickSort multikeyQuickSort;
+	StringSortStrategy* lastStringChoice = nullptr;
+
+	HeapSelect heapSelect;
+	IntroSelect introSelect;
+
+	// files larger than memory are sorted in runs of at most this size;
+	// runs are sorted in place so the budget is not exceeded
+	ExternalSort externalSort{&introSort, DEFAULT_MEMORY_BUDGET};
+
+	// outcome of the last profiling or budgeted configure()
+	InputProfile lastProfile;
+	SortStrategy* lastChoice = nullptr;
+
+	// what the context sorts with, and how to choose it again when the
+	// parallel strategies are replaced
+	SortStrategy* contextChoice = nullptr;
+	std::function<void()> reconfigure;
+
+	// cost of every sort the context has run
+	SortHistory history;
+
+	// below this size the profile is not worth acting on
+	static constexpr size_t SMALL_INPUT = 64;
+	static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(256) << 20;
 
 public:
+	// Limits for one sort. Scratch memory is what the strategy allocates
+	// besides the array itself.
+	struct Budget
+	{
+		double seconds = std::numeric_limits<double>::infinity();
+		size_t scratchBytes = SIZE_MAX;
+	};
+
 	Policy(Context* context) : context(context)
 	{
 		// TODO 5: instantiate the missing attribute
+		context->setSortHistory(&history);
+	}
+
+	// Number of threads a sort may use. With more than one thread the
+	// policy prefers a parallel sort when time is important: the NUMA
+	// aware sample sort on multi-socket hosts, the parallel mergesort
+	// otherwise. The last configure() is repeated with the new budget.
+	void setThreadBudget(unsigned threads)
+	{
+		// the old strategies live until nothing points to them any more
+		std::unique_ptr<ParallelMergeSort> oldParallelMergeSort = std::move(parallelMergeSort);
+		std::unique_ptr<SampleSort> oldSampleSort = std::move(sampleSort);
+		if (threads > 1 && NumaTopology::get().getNodeCount() > 1)
+			sampleSort = std::make_unique<SampleSort>(threads);
+		else if (threads > 1)
+			parallelMergeSort = std::make_unique<ParallelMergeSort>(threads);
+
+		auto replaced = [&](const SortStrategy* strategy)
+		{
+			return strategy != nullptr
+				&& (strategy == oldParallelMergeSort.get() || strategy == oldSampleSort.get());
+		};
+		history.forget(oldParallelMergeSort.get());
+		history.forget(oldSampleSort.get());
+		if (replaced(lastChoice))
+			lastChoice = nullptr;
+		if (replaced(contextChoice))
+			use(&introSort);
+		if (reconfigure)
+		{
+			// configuring replaces reconfigure, so call a copy
+			std::function<void()> again = reconfigure;
+			again();
+		}
+	}
+
+	// The keys are plain 32-bit integers, so when time is important and
+	// space is not, an O(n) radix sort can replace the comparison sorts.
+	void enableRadixSort(bool enable)
+	{
+		radixSortEnabled = enable;
+	}
+
+	// Lets configure() choose the string strategy as well.
+	void setStringContext(StringContext* strings)
+	{
+		stringContext = strings;
+	}
+
+	// Memory an external sort may use for its runs and merge buffers.
+	void setMemoryBudget(size_t bytes)
+	{
+		externalSort.setMemoryBudget(bytes);
+	}
+
+	// For inputs that do not fit into memory: sorts a file of 32-bit
+	// integers within the configured memory budget.
+	ExternalSort& getExternalSort()
+	{
+		return externalSort;
 	}
 
 	virtual void configure(bool timeIsImportant, bool spaceIsImportant)
 	{
 		// TODO 6: add implementation for choosing the appropriate sorting algorithm
-		if (timeIsImportant && !spaceIsImportant)
-			context->setSortAlgorithm(new MergeSort);
+		reconfigure = [this, timeIsImportant, spaceIsImportant] { configure(timeIsImportant, spaceIsImportant); };
+		if (timeIsImportant && !spaceIsImportant && radixSortEnabled)
+			use(&radixSort);
+		else if (timeIsImportant && !spaceIsImportant && sampleSort)
+			use(sampleSort.get());
+		else if (timeIsImportant && !spaceIsImportant && parallelMergeSort)
+			use(parallelMergeSort.get());
+		else if (timeIsImportant && !spaceIsImportant)
+			use(&mergeSort);
 		else if (timeIsImportant && spaceIsImportant)
-			context->setSortAlgorithm(new QuickSort);
+			use(&introSort);
+
+		// MSD radix sort needs a copy of the references, multikey
+		// quicksort works in place
+		if (stringContext != nullptr && timeIsImportant && !spaceIsImportant)
+			stringContext->setSortAlgorithm(&msdRadixSort);
+		else if (stringContext != nullptr)
+			stringContext->setSortAlgorithm(&multikeyQuickSort);
+	}
+
+	// Profiles string keys: with many repeated keys the three-way split of
+	// multikey quicksort finishes them early, otherwise MSD radix sort
+	// does less work per character.
+	void configure(const StringPool& strings, size_t sampleSize = 1024)
+	{
+		size_t n = strings.size();
+		std::vector<std::string_view> sample;
+		for (size_t i = 0; i < n && sample.size() < sampleSize; i += std::max<size_t>(1, n / sampleSize))
+			sample.push_back(strings[i]);
+		std::sort(sample.begin(), sample.end());
+		size_t duplicates = 0;
+		for (size_t i = 1; i < sample.size(); i++)
+			duplicates += sample[i] == sample[i - 1];
+
+		if (n <= SMALL_INPUT || duplicates * 2 > sample.size())
+			lastStringChoice = &multikeyQuickSort;
+		else
+			lastStringChoice = &msdRadixSort;
+
+		if (stringContext != nullptr)
+			stringContext->setSortAlgorithm(lastStringChoice);
+	}
+
+	const char* getLastStringChoice() const
+	{
+		return lastStringChoice != nullptr ? lastStringChoice->getName() : "none";
+	}
+
+	// Chooses how nthElement()/partialSort() find the k smallest of n
+	// values: a bounded heap pays log k per element and wins for small k,
+	// quickselect is linear but moves most of the array.
+	void configureSelection(size_t k, size_t n)
+	{
+		if (k * 16 <= n)
+			context->setSelectAlgorithm(&heapSelect);
+		else
+			context->setSelectAlgorithm(&introSelect);
+	}
+
+	// Profiles the input and chooses the strategy from the data instead of
+	// from the caller's priorities.
+	virtual void configure(const std::vector<int>& input)
+	{
+		lastProfile = InputProfile::of(input);
+		reconfigure = [this] { chooseByProfile(); };
+		chooseByProfile();
+	}
+
+	/***********************************************************************
+	 * Chooses a strategy for sorting n elements within the budget, using
+	 * what each strategy cost in earlier sorts. Strategies that fit into
+	 * the memory budget but have no history yet are tried first, once
+	 * each. Of the measured ones that meet both budgets the one with the
+	 * least scratch memory wins; if none is fast enough, the fastest that
+	 * fits into memory is used, and the in-place IntroSort if none fits.
+	 ***********************************************************************/
+	void configure(size_t n, const Budget& budget)
+	{
+		reconfigure = [this, n, budget] { configure(n, budget); };
+		SortStrategy* fastest = nullptr;
+		double fastestSeconds = 0.0;
+		SortStrategy* leanest = nullptr;
+		size_t leanestBytes = 0;
+		SortStrategy* untried = nullptr;
+		for (SortStrategy* candidate : candidates())
+		{
+			const SortHistory::Entry* entry = history.find(candidate);
+			size_t bytes = predictScratchBytes(candidate, entry, n);
+			if (bytes > budget.scratchBytes)
+				continue;
+			if (entry == nullptr)
+			{
+				if (untried == nullptr)
+					untried = candidate;
+				continue;
+			}
+			double seconds = SortHistory::predictSeconds(*entry, n);
+			if (fastest == nullptr || seconds < fastestSeconds)
+			{
+				fastest = candidate;
+				fastestSeconds = seconds;
+			}
+			if (seconds <= budget.seconds && (leanest == nullptr || bytes < leanestBytes))
+			{
+				leanest = candidate;
+				leanestBytes = bytes;
+			}
+		}
+
+		if (untried != nullptr)
+			lastChoice = untried;
+		else if (leanest != nullptr)
+			lastChoice = leanest;
+		else if (fastest != nullptr)
+			lastChoice = fastest;
+		else
+			lastChoice = &introSort;
+
+		use(lastChoice);
+	}
+
+	const SortHistory& getHistory() const
+	{
+		return history;
+	}
+
+	const InputProfile& getLastProfile() const
+	{
+		return lastProfile;
+	}
+
+	const char* getLastChoice() const
+	{
+		return lastChoice != nullptr ? lastChoice->getName() : "none";
+	}
+
+private:
+	void use(SortStrategy* strategy)
+	{
+		contextChoice = strategy;
+		context->setSortAlgorithm(strategy);
+	}
+
+	// the choice of the profiling configure(), from lastProfile
+	void chooseByProfile()
+	{
+		if (lastProfile.size <= SMALL_INPUT)
+			lastChoice = &introSort;
+		else if (lastProfile.presortedness > 0.9 || lastProfile.runs * 32 <= lastProfile.size)
+			lastChoice = &naturalMergeSort;
+		else if (lastProfile.duplicateRatio > 0.5)
+			lastChoice = &introSort;
+		else if (radixSortEnabled)
+			lastChoice = &radixSort;
+		else if (sampleSort)
+			lastChoice = sampleSort.get();
+		else if (parallelMergeSort)
+			lastChoice = parallelMergeSort.get();
+		else
+			lastChoice = &introSort;
+
+		use(lastChoice);
+	}
+
+	std::vector<SortStrategy*> candidates()
+	{
+		std::vector<SortStrategy*> all = {&introSort, &mergeSort, &naturalMergeSort};
+		if (radixSortEnabled)
+			all.push_back(&radixSort);
+		if (sampleSort)
+			all.push_back(sampleSort.get());
+		if (parallelMergeSort)
+			all.push_back(parallelMergeSort.get());
+		return all;
+	}
+
+	// Measured scratch per element if the counters were compiled in,
+	// otherwise what the strategy is known to need: nothing for the
+	// in-place IntroSort, one buffer of n for the mergesorts and the
+	// radix sort, about two for the sample sort's scatter and buckets.
+	size_t predictScratchBytes(const SortStrategy* strategy, const SortHistory::Entry* entry, size_t n) const
+	{
+		if (SortStats::enabled && entry != nullptr)
+			return static_cast<size_t>(entry->scratchPerElement * n);
+		if (strategy == &introSort)
+			return 0;
+		if (strategy == sampleSort.get())
+			return 2 * n * sizeof(int);
+		return n * sizeof(int);
 	}
 };
 
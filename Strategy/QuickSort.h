@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "SortStrategy.h"
+#include "SortingNetwork.h"
 
 
 class QuickSort : public SortStrategy
@@ -12,6 +13,11 @@ class QuickSort : public SortStrategy
 
 
 	public:
+		const char* getName() const override
+		{
+			return "QuickSort";
+		}
+
 		void performSort(std::vector<int>& a) override
 		{
 			int n = a.size();
@@ -26,21 +32,30 @@ class QuickSort : public SortStrategy
 		{
 			int pivot = end;
 			int j = start;
+			SORT_COUNT_COMPARISONS(end-start);
 			for(int i=start;i<end;++i)
 			{
 				if(v[i]<v[pivot])
 				{
+					SORT_COUNT_MOVES(2);
 					std::swap(v[i],v[j]);
 					++j;
 				}
 			}
 			std::swap(v[j],v[pivot]);
+			SORT_COUNT_MOVES(2);
 			return j;		
 		}
 		
 		void quicksort(std::vector<int>& v, int start, int end)
 		{
-			if(start<end)
+			SORT_TRACE_DEPTH();
+			if(end-start < SortingNetwork::MAX_BLOCK)
+			{
+				if(start<end)
+					SortingNetwork::sortSmall(&v[start], end-start+1);
+			}
+			else
 			{
 				int p = partition(v,start,end);
 				quicksort(v,start,p-1);
@@ -0,0 +1,117 @@
+#ifndef RADIXSORT
+#define RADIXSORT
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "SortStrategy.h"
+
+class RadixSort : public SortStrategy
+{
+	/***********************************************************************
+	 * LSD radix sort for 32-bit signed integers using four 8-bit digits.
+	 *
+	 * The histograms of all four digits are counted in a single read pass.
+	 * The sign bit is flipped while extracting the most significant digit,
+	 * so negative keys sort before positive ones without touching the data.
+	 * A pass whose digit is the same for every key is skipped.
+	 ***********************************************************************/
+public:
+	const char* getName() const override
+	{
+		return "RadixSort";
+	}
+
+	void performSort(std::vector<int>& a) override
+	{
+		// the scratch buffer is kept between calls and only ever grows
+		if (scratch.size() < a.size())
+		{
+			scratch.resize(a.size());
+		}
+		SORT_COUNT_SCRATCH(a.size() * sizeof(int));
+		radixSort(a, scratch.data());
+	}
+
+	void performSort(std::vector<int>& a, ScratchArena& arena) override
+	{
+		radixSort(a, arena.acquire(a.size()));
+	}
+
+	void performSort(std::span<int> a, ScratchArena& arena) override
+	{
+		radixSort(a, arena.acquire(a.size()));
+	}
+
+	static constexpr int DIGITS = 4;
+	static constexpr int BUCKETS = 256;
+
+	// digit d of a key, with the sign bit flipped in the top digit so
+	// that the digits order signed integers correctly
+	static uint32_t digit(uint32_t key, int d)
+	{
+		uint32_t value = (key >> (8 * d)) & 0xFF;
+		return d == DIGITS - 1 ? value ^ 0x80 : value;
+	}
+
+private:
+	std::vector<int> scratch;
+
+	static void radixSort(std::span<int> a, int* buffer)
+	{
+		size_t n = a.size();
+		if (n < 2)
+		{
+			return;
+		}
+
+		size_t count[DIGITS][BUCKETS] = {};
+		for (size_t i = 0; i < n; i++)
+		{
+			uint32_t key = static_cast<uint32_t>(a[i]);
+			count[0][digit(key, 0)]++;
+			count[1][digit(key, 1)]++;
+			count[2][digit(key, 2)]++;
+			count[3][digit(key, 3)]++;
+		}
+
+		int* src = a.data();
+		int* dst = buffer;
+		for (int d = 0; d < DIGITS; d++)
+		{
+			uint32_t first = digit(static_cast<uint32_t>(src[0]), d);
+			if (count[d][first] == n)
+			{
+				continue;
+			}
+
+			size_t offset[BUCKETS];
+			size_t sum = 0;
+			for (int b = 0; b < BUCKETS; b++)
+			{
+				offset[b] = sum;
+				sum += count[d][b];
+			}
+
+			SORT_COUNT_MOVES(n);
+			for (size_t i = 0; i < n; i++)
+			{
+				int value = src[i];
+				dst[offset[digit(static_cast<uint32_t>(value), d)]++] = value;
+			}
+			std::swap(src, dst);
+		}
+
+		// an odd number of passes leaves the result in the scratch buffer
+		if (src != a.data())
+		{
+			SORT_COUNT_MOVES(n);
+			std::copy(src, src + n, a.data());
+		}
+	}
+};
+
+
+#endif	//#ifndef RADIXSORT
@@ -0,0 +1,290 @@
+#ifndef SAMPLESORT
+#define SAMPLESORT
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+#include "MergeSort.h"
+#include "NumaTopology.h"
+#include "SortStrategy.h"
+#include "TaskPool.h"
+
+class SampleSort : public SortStrategy
+{
+	/***********************************************************************
+	 * Parallel super scalar sample sort.
+	 *
+	 * A random sample, oversampled per bucket, yields splitters that are
+	 * stored as an implicit binary search tree, so classifying a key is
+	 * log2(buckets) branch-free steps. Each thread classifies a chunk of
+	 * the input twice, first counting and then scattering into the scratch
+	 * buffer. Every bucket is copied back to its final place and sorted
+	 * there by a pool worker pinned to the NUMA node that holds that
+	 * memory. When the sample repeats a splitter, the keys equal to each
+	 * splitter get a bucket of their own, which needs no sorting, so
+	 * heavily duplicated keys do not pile up in one bucket. Small inputs
+	 * and a single thread use the mergesort directly.
+	 ***********************************************************************/
+public:
+	explicit SampleSort(unsigned threads) : threads(std::max(1u, threads))
+	{
+		// the calling thread is the remaining worker
+		if (this->threads > 1)
+		{
+			pool = std::make_unique<TaskPool>(this->threads - 1);
+		}
+	}
+
+	const char* getName() const override
+	{
+		return "SampleSort";
+	}
+
+	void performSort(std::vector<int>& a) override
+	{
+		ScratchArena scratch;
+		sampleSort(a, scratch);
+	}
+
+	void performSort(std::vector<int>& a, ScratchArena& scratch) override
+	{
+		sampleSort(a, scratch);
+	}
+
+	void performSort(std::span<int> a, ScratchArena& scratch) override
+	{
+		sampleSort(a, scratch);
+	}
+
+private:
+	static constexpr int OVERSAMPLING = 32;
+	static constexpr int MAX_LOG_BUCKETS = 8;
+	static constexpr size_t MIN_PARALLEL_SIZE = 1 << 16;
+
+	unsigned threads;
+	std::unique_ptr<TaskPool> pool;
+	MergeSort bucketSorter{MergeSort::Mode::BottomUp};
+
+	struct SplitterTree
+	{
+		int logBuckets;
+		std::vector<int> tree;		// tree[1] is the root, children of j are 2j and 2j+1
+		std::vector<int> sorted;	// the splitters, padded with the last one
+		bool equalityBuckets;
+
+		int getBucketCount() const
+		{
+			return (1 << logBuckets) << (equalityBuckets ? 1 : 0);
+		}
+
+		// Bucket b holds the keys in (splitter[b-1], splitter[b]]. With
+		// equality buckets that is split into 2b for the keys below
+		// splitter[b] and 2b+1 for the keys equal to it.
+		int classify(int key) const
+		{
+			size_t j = 1;
+			for (int level = 0; level < logBuckets; level++)
+			{
+				j = 2 * j + (key > tree[j]);
+			}
+			int b = static_cast<int>(j - tree.size());
+			return equalityBuckets ? 2 * b + (key == sorted[b]) : b;
+		}
+
+		bool needsSorting(int bucket) const
+		{
+			return !equalityBuckets || bucket % 2 == 0;
+		}
+	};
+
+	void sampleSort(std::span<int> a, ScratchArena& arena)
+	{
+		size_t n = a.size();
+		if (threads == 1 || n < MIN_PARALLEL_SIZE)
+		{
+			bucketSorter.performSort(a, arena);
+			return;
+		}
+		int* scratch = arena.acquire(n);
+
+		int logBuckets = 1;
+		while ((1u << logBuckets) < 4 * threads && logBuckets < MAX_LOG_BUCKETS)
+		{
+			logBuckets++;
+		}
+		SplitterTree splitters = chooseSplitters(a, logBuckets);
+		int buckets = splitters.getBucketCount();
+
+		// pass 1: every thread counts the bucket sizes of its chunk
+		std::vector<std::vector<size_t>> counts(threads, std::vector<size_t>(buckets));
+		runTasks(threads, [&](unsigned t)
+		{
+			auto [first, last] = chunk(n, t);
+			SORT_COUNT_COMPARISONS(uint64_t(last - first) * logBuckets);
+			for (size_t i = first; i < last; i++)
+			{
+				counts[t][splitters.classify(a[i])]++;
+			}
+		});
+
+		// bucket-major prefix sums: bucket b of thread t starts at offset[t][b]
+		std::vector<std::vector<size_t>> offset(threads, std::vector<size_t>(buckets));
+		std::vector<size_t> bucketBegin(buckets + 1);
+		size_t sum = 0;
+		for (int b = 0; b < buckets; b++)
+		{
+			bucketBegin[b] = sum;
+			for (unsigned t = 0; t < threads; t++)
+			{
+				offset[t][b] = sum;
+				sum += counts[t][b];
+			}
+		}
+		bucketBegin[buckets] = n;
+
+		// pass 2: scatter every chunk into its slots of the scratch buffer
+		runTasks(threads, [&](unsigned t)
+		{
+			auto [first, last] = chunk(n, t);
+			std::vector<size_t>& next = offset[t];
+			SORT_COUNT_COMPARISONS(uint64_t(last - first) * logBuckets);
+			SORT_COUNT_MOVES(last - first);
+			for (size_t i = first; i < last; i++)
+			{
+				int key = a[i];
+				scratch[next[splitters.classify(key)]++] = key;
+			}
+		});
+
+		sortBuckets(a, scratch, bucketBegin, splitters);
+	}
+
+	/***********************************************************************
+	 * Buckets are queued on the NUMA node that holds their destination
+	 * range. Each node has pool workers pinned to its CPUs that copy a
+	 * bucket back from scratch and sort it with the bottom-up mergesort;
+	 * equality buckets are only copied.
+	 ***********************************************************************/
+	void sortBuckets(std::span<int> a, const int* scratch, const std::vector<size_t>& bucketBegin,
+		const SplitterTree& splitters)
+	{
+		const NumaTopology& numa = NumaTopology::get();
+		int nodes = numa.getNodeCount();
+		int buckets = static_cast<int>(bucketBegin.size()) - 1;
+
+		std::vector<std::vector<int>> queues(nodes);
+		for (int b = 0; b < buckets; b++)
+		{
+			if (bucketBegin[b] < bucketBegin[b + 1])
+			{
+				queues[numa.nodeOf(a.data() + bucketBegin[b])].push_back(b);
+			}
+		}
+
+		// largest buckets first, so a late big bucket does not stall the end
+		for (std::vector<int>& queue : queues)
+		{
+			std::sort(queue.begin(), queue.end(), [&](int x, int y)
+			{
+				return bucketBegin[x + 1] - bucketBegin[x] > bucketBegin[y + 1] - bucketBegin[y];
+			});
+		}
+
+		std::vector<std::atomic<size_t>> taken(nodes);
+		runTasks(threads, [&](unsigned)
+		{
+			// a worker always serves the same node; the calling thread
+			// keeps its affinity
+			int worker = pool->getWorkerIndex();
+			int home = worker >= 0 ? (worker + 1) % nodes : 0;
+			if (worker >= 0)
+			{
+				numa.pinCurrentThread(home);
+			}
+
+			// node-local scratch for the bucket sorts of this worker
+			ScratchArena local;
+
+			// own node first, then help nodes that have fewer threads
+			for (int k = 0; k < nodes; k++)
+			{
+				int node = (home + k) % nodes;
+				std::vector<int>& queue = queues[node];
+				for (size_t q = taken[node]++; q < queue.size(); q = taken[node]++)
+				{
+					int b = queue[q];
+					std::span<int> bucket = a.subspan(bucketBegin[b], bucketBegin[b + 1] - bucketBegin[b]);
+					SORT_COUNT_MOVES(bucket.size());
+					std::copy(scratch + bucketBegin[b], scratch + bucketBegin[b + 1], bucket.begin());
+					if (splitters.needsSorting(b))
+					{
+						bucketSorter.performSort(bucket, local);
+					}
+				}
+			}
+		});
+	}
+
+	SplitterTree chooseSplitters(std::span<const int> a, int logBuckets) const
+	{
+		int buckets = 1 << logBuckets;
+		std::mt19937_64 rng(a.size());
+		std::vector<int> sample(static_cast<size_t>(OVERSAMPLING) * buckets);
+		for (int& x : sample)
+		{
+			x = a[rng() % a.size()];
+		}
+		std::sort(sample.begin(), sample.end());
+
+		std::vector<int> sorted(buckets - 1);
+		for (int i = 1; i < buckets; i++)
+		{
+			sorted[i - 1] = sample[static_cast<size_t>(i) * OVERSAMPLING];
+		}
+
+		bool repeated = std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end();
+		SplitterTree splitters{logBuckets, std::vector<int>(buckets), sorted, repeated};
+		fillTree(splitters.tree, sorted, 1, 0, buckets - 1);
+		// keys of the last bucket are above every splitter, so this never
+		// matches
+		splitters.sorted.push_back(sorted.back());
+		return splitters;
+	}
+
+	// stores the sorted splitters in breadth-first order
+	static void fillTree(std::vector<int>& tree, const std::vector<int>& sorted, size_t j, int lo, int hi)
+	{
+		if (lo >= hi)
+		{
+			return;
+		}
+		int mid = lo + (hi - lo) / 2;
+		tree[j] = sorted[mid];
+		fillTree(tree, sorted, 2 * j, lo, mid);
+		fillTree(tree, sorted, 2 * j + 1, mid + 1, hi);
+	}
+
+	std::pair<size_t, size_t> chunk(size_t n, unsigned t) const
+	{
+		return {n * t / threads, n * (t + 1) / threads};
+	}
+
+	// runs body(0) .. body(count - 1) on the pool and the calling thread
+	void runTasks(unsigned count, const std::function<void(unsigned)>& body)
+	{
+		TaskPool::TaskGroup group;
+		for (unsigned t = 1; t < count; t++)
+		{
+			pool->spawn(group, [&body, t] { body(t); });
+		}
+		body(0);
+		pool->wait(group);
+	}
+};
+
+
+#endif	//#ifndef SAMPLESORT
@@ -0,0 +1,44 @@
+#ifndef SCRATCHARENA
+#define SCRATCHARENA
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "SortStats.h"
+
+/***********************************************************************
+ * Scratch memory handed to a SortStrategy. The buffer survives between
+ * sort() calls and only ever grows, so repeated sorts of similar sizes
+ * do not allocate. The largest request is remembered for sizing memory
+ * budgets.
+ ***********************************************************************/
+class ScratchArena
+{
+	private:
+		std::vector<int> buffer;
+		size_t peakElements = 0;
+
+	public:
+		int* acquire(size_t elements)
+		{
+			if (buffer.size() < elements)
+			{
+				buffer.resize(elements);
+			}
+			peakElements = std::max(peakElements, elements);
+			SORT_COUNT_SCRATCH(elements * sizeof(int));
+			return buffer.data();
+		}
+
+		size_t getCapacityBytes() const
+		{
+			return buffer.size() * sizeof(int);
+		}
+
+		size_t getPeakBytes() const
+		{
+			return peakElements * sizeof(int);
+		}
+};
+
+#endif	//#ifndef SCRATCHARENA
@@ -0,0 +1,24 @@
+#ifndef SELECTSTRATEGY
+#define SELECTSTRATEGY
+
+#include <cstddef>
+#include <span>
+
+// Counterpart of SortStrategy for callers that only need the smallest
+// values instead of a fully sorted array.
+class SelectStrategy
+{
+	public:
+		virtual ~SelectStrategy() = default;
+
+		// Afterwards a[k] holds the value a full sort would put there,
+		// nothing before it is larger and nothing after it is smaller.
+		virtual void nthElement(std::span<int> a, size_t k) = 0;
+
+		// Afterwards a[0] .. a[k-1] are the k smallest values, ascending.
+		virtual void partialSort(std::span<int> a, size_t k) = 0;
+
+		virtual const char* getName() const = 0;
+};
+
+#endif	//#ifndef SELECTSTRATEGY
@@ -0,0 +1,73 @@
+#ifndef SORTHISTORY
+#define SORTHISTORY
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include "SortStats.h"
+#include "SortStrategy.h"
+
+/***********************************************************************
+ * What each strategy has cost so far, normalised by input size so that
+ * runs of different sizes can predict each other: time per n log2 n and
+ * scratch bytes per element. Context records every sort it runs, Policy
+ * reads the history to pick a strategy that meets its budgets.
+ ***********************************************************************/
+class SortHistory
+{
+public:
+	struct Entry
+	{
+		size_t sorts = 0;
+		double secondsPerUnit = 0.0;	// mean of seconds / (n log2 n)
+		double scratchPerElement = 0.0;	// mean of scratch bytes / n
+		SortStats last;
+	};
+
+	void record(const SortStrategy* strategy, size_t n, const SortStats& stats)
+	{
+		if (n < 2)
+		{
+			return;
+		}
+		Entry& entry = entries[strategy];
+		entry.sorts++;
+		entry.secondsPerUnit += (stats.seconds / work(n) - entry.secondsPerUnit) / entry.sorts;
+		entry.scratchPerElement += (double(stats.scratchBytes) / n - entry.scratchPerElement) / entry.sorts;
+		entry.last = stats;
+	}
+
+	// nullptr if the strategy has not sorted anything yet
+	const Entry* find(const SortStrategy* strategy) const
+	{
+		auto it = entries.find(strategy);
+		return it != entries.end() ? &it->second : nullptr;
+	}
+
+	static double predictSeconds(const Entry& entry, size_t n)
+	{
+		return entry.secondsPerUnit * work(n);
+	}
+
+	// for strategies that are destroyed, so a new one at the same address
+	// does not inherit their costs
+	void forget(const SortStrategy* strategy)
+	{
+		entries.erase(strategy);
+	}
+
+	void clear()
+	{
+		entries.clear();
+	}
+
+private:
+	std::map<const SortStrategy*, Entry> entries;
+
+	static double work(size_t n)
+	{
+		return n * std::log2(static_cast<double>(std::max<size_t>(n, 2)));
+	}
+};
+
+#endif	//#ifndef SORTHISTORY
@@ -0,0 +1,278 @@
+#ifndef SORTSTATS
+#define SORTSTATS
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#ifdef SORT_INSTRUMENTATION
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+/***********************************************************************
+ * What one performSort() call did. Wall time is always measured; the
+ * counters are only filled in when the strategies are compiled with
+ * SORT_INSTRUMENTATION defined, otherwise the counting macros below
+ * expand to nothing and the counters stay zero.
+ ***********************************************************************/
+struct SortStats
+{
+#ifdef SORT_INSTRUMENTATION
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	uint64_t comparisons = 0;
+	uint64_t moves = 0;			// element writes, a swap counts as two
+	uint64_t scratchBytes = 0;	// scratch memory the sort asked for
+	int maxDepth = 0;			// deepest recursion on any thread
+	double seconds = 0.0;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const SortStats& stats)
+{
+	return out << "comparisons=" << stats.comparisons
+		<< " moves=" << stats.moves
+		<< " scratch=" << stats.scratchBytes
+		<< " depth=" << stats.maxDepth
+		<< " seconds=" << stats.seconds;
+}
+
+#ifdef SORT_INSTRUMENTATION
+/***********************************************************************
+ * Every thread counts into its own block, so the hot loops never share
+ * a cache line. When a thread exits, its counts are folded into a
+ * retired total and the block goes on a free list for the next thread,
+ * so threads that come and go neither leak blocks nor slow down total().
+ * Only the owning thread writes a block, the relaxed atomics just make
+ * reading it from a probe legal.
+ *
+ * Recursion depth is tracked per depth window: a probe opens a new
+ * window, and a thread's maximum starts over when it next enters its
+ * outermost level in that window, keeping the previous window's maximum
+ * beside it. A thread's maximum is never cleared while it is recursing,
+ * so probes on other threads do not disturb a running sort.
+ ***********************************************************************/
+class SortCounters
+{
+public:
+	struct Block
+	{
+		std::atomic<uint64_t> comparisons{0};
+		std::atomic<uint64_t> moves{0};
+		std::atomic<uint64_t> scratchBytes{0};
+		std::atomic<int> depth{0};
+		std::atomic<int> maxDepth{0};
+		std::atomic<uint64_t> window{0};	// depth window maxDepth belongs to
+		std::atomic<int> previousMaxDepth{0};
+		std::atomic<uint64_t> previousWindow{0};
+
+		int maxDepthSince(uint64_t fromWindow) const
+		{
+			int depth = 0;
+			if (window.load(std::memory_order_relaxed) >= fromWindow)
+			{
+				depth = maxDepth.load(std::memory_order_relaxed);
+			}
+			if (previousWindow.load(std::memory_order_relaxed) >= fromWindow)
+			{
+				depth = std::max(depth, previousMaxDepth.load(std::memory_order_relaxed));
+			}
+			return depth;
+		}
+	};
+
+	static Block& local()
+	{
+		thread_local Lease lease;
+		return *lease.block;
+	}
+
+	static void add(std::atomic<uint64_t>& counter, uint64_t n)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	// Counters summed over all threads, including the ones that have
+	// exited; depth is the maximum reached since depth window fromWindow
+	// was opened
+	static SortStats total(uint64_t fromWindow = 0)
+	{
+		Registry& registry = get();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		SortStats sum = registry.retired;
+		sum.maxDepth = registry.retiredWindow >= fromWindow ? registry.retired.maxDepth : 0;
+		for (const Block* block : registry.active)
+		{
+			sum.comparisons += block->comparisons.load(std::memory_order_relaxed);
+			sum.moves += block->moves.load(std::memory_order_relaxed);
+			sum.scratchBytes += block->scratchBytes.load(std::memory_order_relaxed);
+			sum.maxDepth = std::max(sum.maxDepth, block->maxDepthSince(fromWindow));
+		}
+		return sum;
+	}
+
+	// opens a new depth window and returns it
+	static uint64_t openDepthWindow()
+	{
+		return get().window.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+	// counts one level of recursion for as long as it is in scope
+	class DepthGuard
+	{
+	public:
+		DepthGuard() : block(local())
+		{
+			int depth = block.depth.load(std::memory_order_relaxed) + 1;
+			block.depth.store(depth, std::memory_order_relaxed);
+			uint64_t window = get().window.load(std::memory_order_relaxed);
+			if (depth == 1 && block.window.load(std::memory_order_relaxed) != window)
+			{
+				block.previousWindow.store(block.window.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				block.previousMaxDepth.store(block.maxDepth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				block.window.store(window, std::memory_order_relaxed);
+				block.maxDepth.store(depth, std::memory_order_relaxed);
+			}
+			else if (depth > block.maxDepth.load(std::memory_order_relaxed))
+			{
+				block.maxDepth.store(depth, std::memory_order_relaxed);
+			}
+		}
+
+		~DepthGuard()
+		{
+			block.depth.store(block.depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		}
+
+	private:
+		Block& block;
+	};
+
+private:
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Block>> all;
+		std::vector<Block*> active;
+		std::vector<Block*> free;
+		SortStats retired;			// counts of threads that have exited
+		uint64_t retiredWindow = 0;	// depth window of retired.maxDepth
+		std::atomic<uint64_t> window{0};
+	};
+
+	static Registry& get()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// a thread's hold on its block, returned when the thread exits
+	struct Lease
+	{
+		Block* block;
+
+		Lease()
+		{
+			Registry& registry = get();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			if (registry.free.empty())
+			{
+				registry.all.push_back(std::make_unique<Block>());
+				block = registry.all.back().get();
+			}
+			else
+			{
+				block = registry.free.back();
+				registry.free.pop_back();
+			}
+			registry.active.push_back(block);
+		}
+
+		~Lease()
+		{
+			Registry& registry = get();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.retired.comparisons += block->comparisons.exchange(0, std::memory_order_relaxed);
+			registry.retired.moves += block->moves.exchange(0, std::memory_order_relaxed);
+			registry.retired.scratchBytes += block->scratchBytes.exchange(0, std::memory_order_relaxed);
+			uint64_t window = block->window.load(std::memory_order_relaxed);
+			int maxDepth = block->maxDepthSince(window);
+			block->window.store(0, std::memory_order_relaxed);
+			block->maxDepth.store(0, std::memory_order_relaxed);
+			block->previousWindow.store(0, std::memory_order_relaxed);
+			block->previousMaxDepth.store(0, std::memory_order_relaxed);
+			if (window > registry.retiredWindow)
+			{
+				registry.retiredWindow = window;
+				registry.retired.maxDepth = maxDepth;
+			}
+			else if (window == registry.retiredWindow)
+			{
+				registry.retired.maxDepth = std::max(registry.retired.maxDepth, maxDepth);
+			}
+			block->depth.store(0, std::memory_order_relaxed);
+			registry.active.erase(std::find(registry.active.begin(), registry.active.end(), block));
+			registry.free.push_back(block);
+		}
+
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+	};
+};
+
+#define SORT_COUNT_COMPARISONS(n) SortCounters::add(SortCounters::local().comparisons, (n))
+#define SORT_COUNT_MOVES(n) SortCounters::add(SortCounters::local().moves, (n))
+#define SORT_COUNT_SCRATCH(bytes) SortCounters::add(SortCounters::local().scratchBytes, (bytes))
+#define SORT_TRACE_DEPTH() SortCounters::DepthGuard sortDepthGuard
+#else
+#define SORT_COUNT_COMPARISONS(n) ((void)0)
+#define SORT_COUNT_MOVES(n) ((void)0)
+#define SORT_COUNT_SCRATCH(bytes) ((void)0)
+#define SORT_TRACE_DEPTH() ((void)0)
+#endif
+
+/***********************************************************************
+ * Records into stats what happens between construction and destruction.
+ * Counters are global, so sorts running concurrently on other threads
+ * are counted as well.
+ ***********************************************************************/
+class SortProbe
+{
+public:
+	explicit SortProbe(SortStats& stats) : stats(stats), start(std::chrono::steady_clock::now())
+	{
+#ifdef SORT_INSTRUMENTATION
+		depthWindow = SortCounters::openDepthWindow();
+		before = SortCounters::total();
+#endif
+	}
+
+	~SortProbe()
+	{
+		stats = SortStats();
+#ifdef SORT_INSTRUMENTATION
+		SortStats after = SortCounters::total(depthWindow);
+		stats.comparisons = after.comparisons - before.comparisons;
+		stats.moves = after.moves - before.moves;
+		stats.scratchBytes = after.scratchBytes - before.scratchBytes;
+		stats.maxDepth = after.maxDepth;
+#endif
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	SortStats& stats;
+	std::chrono::steady_clock::time_point start;
+#ifdef SORT_INSTRUMENTATION
+	SortStats before;
+	uint64_t depthWindow;
+#endif
+};
+
+#endif	//#ifndef SORTSTATS
@@ -1,11 +1,61 @@
 #ifndef SORTSTRATEGY
 #define SORTSTRATEGY
 
+#include <algorithm>
+#include <span>
+#include <vector>
+#include "ScratchArena.h"
+#include "SortStats.h"
+
 class SortStrategy
 {
 	public:
+		virtual ~SortStrategy() = default;
+
 		// TODO 1: add the missing interface method
 		virtual void performSort(std::vector<int>&) = 0;
+
+		virtual const char* getName() const = 0;
+
+		// Strategies that need scratch memory can take it from the
+		// caller's arena instead of allocating on every call.
+		virtual void performSort(std::vector<int>& a, ScratchArena&)
+		{
+			performSort(a);
+		}
+
+		// Sorts memory the caller owns. Strategies that can work on any
+		// contiguous range override this; the default sorts a copy.
+		virtual void performSort(std::span<int> a, ScratchArena& scratch)
+		{
+			std::vector<int> copy(a.begin(), a.end());
+			SORT_COUNT_SCRATCH(a.size() * sizeof(int));
+			SORT_COUNT_MOVES(2 * a.size());
+			performSort(copy, scratch);
+			std::copy(copy.begin(), copy.end(), a.begin());
+		}
+
+		// Sort through performSort() and record what the call did in
+		// getLastStats().
+		void measuredSort(std::vector<int>& a, ScratchArena& scratch)
+		{
+			SortProbe probe(lastStats);
+			performSort(a, scratch);
+		}
+
+		void measuredSort(std::span<int> a, ScratchArena& scratch)
+		{
+			SortProbe probe(lastStats);
+			performSort(a, scratch);
+		}
+
+		const SortStats& getLastStats() const
+		{
+			return lastStats;
+		}
+
+	private:
+		SortStats lastStats;
 };
 
 #endif	//#ifndef SORTSTRATEGY
@@ -0,0 +1,342 @@
+#ifndef SORTINGNETWORK
+#define SORTINGNETWORK
+
+#include <algorithm>
+#include <climits>
+#include "SortStats.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SORTINGNETWORK_X86
+#include <immintrin.h>
+#endif
+
+/***********************************************************************
+ * Branch-free base cases for the sorting strategies.
+ *
+ * sortSmall() sorts up to MAX_BLOCK ints with a bitonic sorting network,
+ * merge() merges two sorted ranges eight elements at a time. On x86 the
+ * AVX2 or SSE4.1 kernels are chosen once at runtime from the CPU's
+ * features; everywhere else, and on older CPUs, insertion sort and a
+ * plain merge are used.
+ ***********************************************************************/
+class SortingNetwork
+{
+public:
+	static constexpr int MAX_BLOCK = 64;
+
+	// sort a[0] .. a[n-1], n <= MAX_BLOCK
+	static void sortSmall(int* a, int n)
+	{
+		if (n > 1)
+		{
+			SORT_COUNT_MOVES(n);
+			kernels().sort(a, n);
+		}
+	}
+
+	// merge a[0] .. a[na-1] and b[0] .. b[nb-1] into out[0] .. out[na+nb-1]
+	static void merge(const int* a, int na, const int* b, int nb, int* out)
+	{
+		// the vector kernel compares whole registers; count what a scalar
+		// merge of the same inputs would at most compare
+		SORT_COUNT_COMPARISONS(na + nb);
+		SORT_COUNT_MOVES(na + nb);
+		kernels().merge(a, na, b, nb, out);
+	}
+
+	static const char* getKernelName()
+	{
+		return kernels().name;
+	}
+
+private:
+	struct Kernels
+	{
+		const char* name;
+		void (*sort)(int*, int);
+		void (*merge)(const int*, int, const int*, int, int*);
+	};
+
+	static const Kernels& kernels()
+	{
+		static const Kernels selected = select();
+		return selected;
+	}
+
+	static Kernels select()
+	{
+#ifdef SORTINGNETWORK_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return {"avx2", avx2Sort, avx2Merge};
+		}
+		if (__builtin_cpu_supports("sse4.1"))
+		{
+			return {"sse4.1", sse4Sort, scalarMerge};
+		}
+#endif
+		return {"scalar", scalarSort, scalarMerge};
+	}
+
+	static void scalarSort(int* a, int n)
+	{
+		for (int i = 1; i < n; i++)
+		{
+			int value = a[i];
+			int j = i;
+			while (j > 0 && value < a[j - 1])
+			{
+				SORT_COUNT_COMPARISONS(1);
+				SORT_COUNT_MOVES(1);
+				a[j] = a[j - 1];
+				j--;
+			}
+			SORT_COUNT_COMPARISONS(j > 0);
+			a[j] = value;
+		}
+	}
+
+	static void scalarMerge(const int* a, int na, const int* b, int nb, int* out)
+	{
+		std::merge(a, a + na, b, b + nb, out);
+	}
+
+	// smallest power of two >= n and >= minimum
+	static int paddedSize(int n, int minimum)
+	{
+		int m = minimum;
+		while (m < n)
+		{
+			m *= 2;
+		}
+		return m;
+	}
+
+	// compare-exchanges of a bitonic network on m = 2^k elements
+	static uint64_t networkSize(int m)
+	{
+		uint64_t k = 0;
+		while ((1 << k) < m)
+		{
+			k++;
+		}
+		return uint64_t(m) / 2 * k * (k + 1) / 2;
+	}
+
+#ifdef SORTINGNETWORK_X86
+	/***********************************************************************
+	 * Bitonic sort of a block padded with INT_MAX to a power of two.
+	 * Stage (k, j) compare-exchanges elements i and i^j, ascending where
+	 * i & k is zero. For j >= lanes the partners sit in different
+	 * registers; for smaller j they are brought together with a permute
+	 * and every lane picks min or max through a blend mask.
+	 ***********************************************************************/
+	__attribute__((target("avx2")))
+	static void avx2Sort(int* a, int n)
+	{
+		alignas(32) int block[MAX_BLOCK];
+		int m = paddedSize(n, 8);
+		SORT_COUNT_COMPARISONS(networkSize(m));
+		std::copy(a, a + n, block);
+		std::fill(block + n, block + m, INT_MAX);
+
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (int k = 2; k <= m; k *= 2)
+		{
+			for (int j = k / 2; j > 0; j /= 2)
+			{
+				if (j >= 8)
+				{
+					for (int i = 0; i < m; i += 8)
+					{
+						if ((i & j) != 0)
+						{
+							continue;
+						}
+						__m256i lo = _mm256_load_si256(reinterpret_cast<__m256i*>(block + i));
+						__m256i hi = _mm256_load_si256(reinterpret_cast<__m256i*>(block + i + j));
+						__m256i mn = _mm256_min_epi32(lo, hi);
+						__m256i mx = _mm256_max_epi32(lo, hi);
+						bool ascending = (i & k) == 0;
+						_mm256_store_si256(reinterpret_cast<__m256i*>(block + i), ascending ? mn : mx);
+						_mm256_store_si256(reinterpret_cast<__m256i*>(block + i + j), ascending ? mx : mn);
+					}
+					continue;
+				}
+
+				const __m256i partner = _mm256_xor_si256(lanes, _mm256_set1_epi32(j));
+				const __m256i jMask = _mm256_set1_epi32(j);
+				const __m256i kMask = _mm256_set1_epi32(k);
+				const __m256i upper = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, jMask), jMask);
+				for (int i = 0; i < m; i += 8)
+				{
+					__m256i v = _mm256_load_si256(reinterpret_cast<__m256i*>(block + i));
+					__m256i p = _mm256_permutevar8x32_epi32(v, partner);
+					__m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(i));
+					__m256i descending = _mm256_cmpeq_epi32(_mm256_and_si256(index, kMask), kMask);
+					__m256i takeMax = _mm256_xor_si256(upper, descending);
+					v = _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), takeMax);
+					_mm256_store_si256(reinterpret_cast<__m256i*>(block + i), v);
+				}
+			}
+		}
+		std::copy(block, block + n, a);
+	}
+
+	// sort a bitonic register ascending
+	__attribute__((target("avx2")))
+	static __m256i avx2BitonicClean(__m256i v)
+	{
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (int j = 4; j > 0; j /= 2)
+		{
+			const __m256i jMask = _mm256_set1_epi32(j);
+			__m256i p = _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(lanes, jMask));
+			__m256i upper = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, jMask), jMask);
+			v = _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), upper);
+		}
+		return v;
+	}
+
+	/***********************************************************************
+	 * Merge with an 8+8 bitonic merge network: the smaller half of the
+	 * two registers is written out, the larger half is merged with the
+	 * next block from whichever input has the smaller next element. The
+	 * tails that do not fill a register are merged in scalar code.
+	 ***********************************************************************/
+	__attribute__((target("avx2")))
+	static void avx2Merge(const int* a, int na, const int* b, int nb, int* out)
+	{
+		if (na < 8 || nb < 8)
+		{
+			scalarMerge(a, na, b, nb, out);
+			return;
+		}
+
+		const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+		__m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+		int ia = 8;
+		int ib = 8;
+		while (true)
+		{
+			__m256i reversed = _mm256_permutevar8x32_epi32(high, reverse);
+			__m256i mn = _mm256_min_epi32(low, reversed);
+			__m256i mx = _mm256_max_epi32(low, reversed);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), avx2BitonicClean(mn));
+			out += 8;
+			high = avx2BitonicClean(mx);
+
+			// Loading from the input with the smaller head keeps every
+			// carried element <= both heads, so the next eight written are
+			// final. A partial block on the smaller side ends the loop.
+			bool takeA = ia + 8 <= na && (ib == nb || a[ia] <= b[ib]);
+			bool takeB = !takeA && ib + 8 <= nb && (ia == na || b[ib] < a[ia]);
+			if (takeA)
+			{
+				low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + ia));
+				ia += 8;
+			}
+			else if (takeB)
+			{
+				low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + ib));
+				ib += 8;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		// three-way scalar merge of the carried register and both tails
+		alignas(32) int carried[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(carried), high);
+		int ic = 0;
+		while (ic < 8 || ia < na || ib < nb)
+		{
+			int best = 0;	// 0: carried, 1: a, 2: b
+			int value = INT_MAX;
+			bool found = false;
+			if (ic < 8)
+			{
+				value = carried[ic];
+				found = true;
+			}
+			if (ia < na && (!found || a[ia] < value))
+			{
+				value = a[ia];
+				best = 1;
+				found = true;
+			}
+			if (ib < nb && (!found || b[ib] < value))
+			{
+				value = b[ib];
+				best = 2;
+			}
+			*out++ = value;
+			if (best == 0)
+				ic++;
+			else if (best == 1)
+				ia++;
+			else
+				ib++;
+		}
+	}
+
+	// same network as avx2Sort with four lanes per register
+	__attribute__((target("sse4.1")))
+	static void sse4Sort(int* a, int n)
+	{
+		alignas(16) int block[MAX_BLOCK];
+		int m = paddedSize(n, 4);
+		SORT_COUNT_COMPARISONS(networkSize(m));
+		std::copy(a, a + n, block);
+		std::fill(block + n, block + m, INT_MAX);
+
+		const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+		for (int k = 2; k <= m; k *= 2)
+		{
+			for (int j = k / 2; j > 0; j /= 2)
+			{
+				if (j >= 4)
+				{
+					for (int i = 0; i < m; i += 4)
+					{
+						if ((i & j) != 0)
+						{
+							continue;
+						}
+						__m128i lo = _mm_load_si128(reinterpret_cast<__m128i*>(block + i));
+						__m128i hi = _mm_load_si128(reinterpret_cast<__m128i*>(block + i + j));
+						__m128i mn = _mm_min_epi32(lo, hi);
+						__m128i mx = _mm_max_epi32(lo, hi);
+						bool ascending = (i & k) == 0;
+						_mm_store_si128(reinterpret_cast<__m128i*>(block + i), ascending ? mn : mx);
+						_mm_store_si128(reinterpret_cast<__m128i*>(block + i + j), ascending ? mx : mn);
+					}
+					continue;
+				}
+
+				const __m128i jMask = _mm_set1_epi32(j);
+				const __m128i kMask = _mm_set1_epi32(k);
+				const __m128i upper = _mm_cmpeq_epi32(_mm_and_si128(lanes, jMask), jMask);
+				for (int i = 0; i < m; i += 4)
+				{
+					__m128i v = _mm_load_si128(reinterpret_cast<__m128i*>(block + i));
+					__m128i p = j == 2 ? _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))
+						: _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+					__m128i index = _mm_add_epi32(lanes, _mm_set1_epi32(i));
+					__m128i descending = _mm_cmpeq_epi32(_mm_and_si128(index, kMask), kMask);
+					__m128i takeMax = _mm_xor_si128(upper, descending);
+					v = _mm_blendv_epi8(_mm_min_epi32(v, p), _mm_max_epi32(v, p), takeMax);
+					_mm_store_si128(reinterpret_cast<__m128i*>(block + i), v);
+				}
+			}
+		}
+		std::copy(block, block + n, a);
+	}
+#endif
+};
+
+#endif	//#ifndef SORTINGNETWORK
@@ -0,0 +1,45 @@
+#ifndef _STRINGCONTEXT_H_
+#define _STRINGCONTEXT_H_
+
+#include "StringPool.h"
+#include "StringSortStrategy.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Context for string keys. The strings are held in a StringPool and
+// the selected StringSortStrategy reorders the pool's references.
+class StringContext
+{
+	private:
+		StringSortStrategy* sortAlgorithm = nullptr;
+		StringPool pool;
+
+	public:
+		void setSortAlgorithm(StringSortStrategy* sortStrategy)
+		{
+			sortAlgorithm = sortStrategy;
+		}
+
+		void setArray(const std::vector<std::string>& strings)
+		{
+			pool = StringPool(strings);
+		}
+
+		void setArray(StringPool&& strings)
+		{
+			pool = std::move(strings);
+		}
+
+		void sort()
+		{
+			sortAlgorithm->performSort(pool);
+		}
+
+		StringPool& getArray()
+		{
+			return pool;
+		}
+};
+
+#endif // _STRINGCONTEXT_H_
@@ -0,0 +1,103 @@
+#ifndef STRINGPOOL
+#define STRINGPOOL
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/***********************************************************************
+ * Strings stored back to back in one character buffer, addressed by an
+ * array of (offset, length) references.
+ *
+ * The string sorts permute only the 8-byte references, so no string is
+ * copied and reading a character is an index into one buffer instead of
+ * a pointer chase to a separately allocated std::string. Offsets are 32
+ * bits, so a pool holds at most 4 GiB of characters; adding more throws
+ * std::length_error.
+ ***********************************************************************/
+class StringPool
+{
+public:
+	struct Ref
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	StringPool() = default;
+
+	explicit StringPool(const std::vector<std::string>& strings)
+	{
+		size_t total = 0;
+		for (const std::string& s : strings)
+		{
+			total += s.size();
+		}
+		chars.reserve(total);
+		refs.reserve(strings.size());
+		for (const std::string& s : strings)
+		{
+			add(s);
+		}
+	}
+
+	void add(std::string_view s)
+	{
+		if (s.size() > UINT32_MAX - chars.size())
+		{
+			throw std::length_error("StringPool: more than 4 GiB of characters");
+		}
+		refs.push_back({static_cast<uint32_t>(chars.size()), static_cast<uint32_t>(s.size())});
+		chars.insert(chars.end(), s.begin(), s.end());
+	}
+
+	size_t size() const
+	{
+		return refs.size();
+	}
+
+	std::string_view operator[](size_t i) const
+	{
+		return view(refs[i]);
+	}
+
+	std::string_view view(Ref ref) const
+	{
+		return std::string_view(chars.data() + ref.offset, ref.length);
+	}
+
+	// character at depth, or -1 past the end so shorter strings sort first
+	int charAt(Ref ref, size_t depth) const
+	{
+		return depth < ref.length ? static_cast<unsigned char>(chars[ref.offset + depth]) : -1;
+	}
+
+	std::vector<Ref>& getRefs()
+	{
+		return refs;
+	}
+
+	const std::vector<Ref>& getRefs() const
+	{
+		return refs;
+	}
+
+	std::vector<std::string> toStrings() const
+	{
+		std::vector<std::string> strings;
+		strings.reserve(refs.size());
+		for (Ref ref : refs)
+		{
+			strings.emplace_back(view(ref));
+		}
+		return strings;
+	}
+
+private:
+	std::vector<char> chars;
+	std::vector<Ref> refs;
+};
+
+#endif	//#ifndef STRINGPOOL
@@ -0,0 +1,18 @@
+#ifndef STRINGSORTSTRATEGY
+#define STRINGSORTSTRATEGY
+
+#include "StringPool.h"
+
+// Counterpart of SortStrategy for string keys: sorts the references of
+// a StringPool into lexicographic (byte-wise) order.
+class StringSortStrategy
+{
+	public:
+		virtual ~StringSortStrategy() = default;
+
+		virtual void performSort(StringPool&) = 0;
+
+		virtual const char* getName() const = 0;
+};
+
+#endif	//#ifndef STRINGSORTSTRATEGY
@@ -0,0 +1,206 @@
+#ifndef TASKPOOL
+#define TASKPOOL
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************************
+ * A small work-stealing thread pool for fork-join parallelism.
+ *
+ * Every worker owns a deque: it pushes and pops its own tasks at the back
+ * and idle workers steal from the front of other deques. A thread that
+ * waits for a TaskGroup keeps executing pending tasks instead of blocking,
+ * so nested fork-join recursion cannot deadlock the pool.
+ ***********************************************************************/
+class TaskPool
+{
+public:
+	class TaskGroup
+	{
+		friend class TaskPool;
+		std::atomic<int> pending{0};
+	};
+
+	explicit TaskPool(unsigned threads)
+	{
+		if (threads == 0)
+		{
+			threads = 1;
+		}
+		for (unsigned i = 0; i < threads; i++)
+		{
+			queues.push_back(std::make_unique<WorkQueue>());
+		}
+		for (unsigned i = 0; i < threads; i++)
+		{
+			workers.emplace_back([this, i] { workerLoop(i); });
+		}
+	}
+
+	~TaskPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	unsigned size() const
+	{
+		return static_cast<unsigned>(workers.size());
+	}
+
+	// index of the calling worker, or -1 if it is not one of this pool's
+	int getWorkerIndex() const
+	{
+		return currentWorker();
+	}
+
+	void spawn(TaskGroup& group, std::function<void()> task)
+	{
+		group.pending.fetch_add(1, std::memory_order_relaxed);
+		auto wrapped = [&group, task = std::move(task)]
+		{
+			task();
+			group.pending.fetch_sub(1, std::memory_order_release);
+		};
+
+		WorkQueue& queue = *queues[currentWorker() >= 0 ? currentWorker() : nextQueue++ % queues.size()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(wrapped));
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			queued++;
+		}
+		wakeUp.notify_one();
+	}
+
+	// Blocks until every task spawned into the group has finished, running
+	// queued tasks in the meantime.
+	void wait(TaskGroup& group)
+	{
+		while (group.pending.load(std::memory_order_acquire) > 0)
+		{
+			if (!runOne(currentWorker()))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<unsigned> nextQueue{0};
+
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	long queued = 0;
+	bool stopping = false;
+
+	struct WorkerIdentity
+	{
+		const TaskPool* pool = nullptr;
+		int index = -1;
+	};
+
+	static WorkerIdentity& identity()
+	{
+		thread_local WorkerIdentity self;
+		return self;
+	}
+
+	// index of the calling thread inside this pool, -1 for outside threads
+	int currentWorker() const
+	{
+		return identity().pool == this ? identity().index : -1;
+	}
+
+	bool takeTask(int self, std::function<void()>& task)
+	{
+		int n = static_cast<int>(queues.size());
+		if (self >= 0)
+		{
+			WorkQueue& own = *queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		// steal the oldest (largest) task from someone else
+		int start = self >= 0 ? self + 1 : 0;
+		for (int k = 0; k < n; k++)
+		{
+			WorkQueue& victim = *queues[(start + k) % n];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool runOne(int self)
+	{
+		std::function<void()> task;
+		if (!takeTask(self, task))
+		{
+			return false;
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			queued--;
+		}
+		task();
+		return true;
+	}
+
+	void workerLoop(int index)
+	{
+		identity() = WorkerIdentity{this, index};
+		while (true)
+		{
+			if (runOne(index))
+			{
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+			if (stopping)
+			{
+				return;
+			}
+		}
+	}
+};
+
+#endif	//#ifndef TASKPOOL
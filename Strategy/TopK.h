@@ -0,0 +1,118 @@
+#ifndef TOPK
+#define TOPK
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TOPK_X86
+#include <immintrin.h>
+#endif
+
+/***********************************************************************
+ * Streaming selection of the k smallest values seen so far.
+ *
+ * The values are kept in a bounded max-heap whose top is the current
+ * k-th smallest value. Once the heap is full, most values of a long
+ * stream are larger than that threshold; push(span) therefore compares
+ * eight values at a time against it (AVX2, when the CPU has it) and only
+ * touches the heap for blocks that contain a candidate.
+ ***********************************************************************/
+class TopK
+{
+public:
+	explicit TopK(size_t k) : k(k)
+	{
+		heap.reserve(k);
+	}
+
+	void push(int value)
+	{
+		if (heap.size() < k)
+		{
+			heap.push_back(value);
+			std::push_heap(heap.begin(), heap.end());
+		}
+		else if (k > 0 && value < heap.front())
+		{
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = value;
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+
+	void push(std::span<const int> values)
+	{
+		size_t i = 0;
+		while (i < values.size() && heap.size() < k)
+		{
+			push(values[i++]);
+		}
+		if (k == 0)
+		{
+			return;
+		}
+#ifdef TOPK_X86
+		static const bool avx2 = __builtin_cpu_supports("avx2");
+		if (avx2)
+		{
+			i = filterAvx2(values, i);
+		}
+#endif
+		for (; i < values.size(); i++)
+		{
+			push(values[i]);
+		}
+	}
+
+	// current k-th smallest value; only meaningful once size() == k
+	int threshold() const
+	{
+		return heap.front();
+	}
+
+	size_t size() const
+	{
+		return heap.size();
+	}
+
+	// the kept values in ascending order
+	std::vector<int> result() const
+	{
+		std::vector<int> sorted = heap;
+		std::sort_heap(sorted.begin(), sorted.end());
+		return sorted;
+	}
+
+private:
+	size_t k;
+	std::vector<int> heap;
+
+#ifdef TOPK_X86
+	// pushes values[i] .. in blocks of eight, skipping blocks without a
+	// value below the threshold; returns where the scalar tail starts
+	__attribute__((target("avx2")))
+	size_t filterAvx2(std::span<const int> values, size_t i)
+	{
+		__m256i limit = _mm256_set1_epi32(heap.front());
+		for (; i + 8 <= values.size(); i += 8)
+		{
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + i));
+			if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(limit, block)) == 0)
+			{
+				continue;
+			}
+			for (size_t j = i; j < i + 8; j++)
+			{
+				push(values[j]);
+			}
+			limit = _mm256_set1_epi32(heap.front());
+		}
+		return i;
+	}
+#endif
+};
+
+#endif	//#ifndef TOPK